@@ -30,6 +30,34 @@
 #define hwSPI true
 #endif
 
+// Largest horizontal text scale drawn with a single address window; one
+// scaled glyph row must fit the line buffer
+#define GLYPH_MAX_SIZE 8
+#define GLYPH_LINE_BYTES (6 * GLYPH_MAX_SIZE * 2)
+
+// Reads the columns of a built-in font glyph by letting Adafruit_GFX draw
+// it, so the font table in Adafruit_GFX stays the only copy in flash
+class GlyphReader : public Adafruit_GFX {
+
+ public:
+  GlyphReader(void) : Adafruit_GFX(6, 8) {}
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if(color) columns[x] |= 1 << y;
+  }
+
+  const uint8_t * read(unsigned char c, boolean classic) {
+    memset(columns, 0, sizeof(columns));
+    cp437(!classic);
+    drawChar(0, 0, c, 1, 1, 1);
+    return columns;
+  }
+
+  uint8_t columns[6];
+};
+
+static GlyphReader glyphReader;
+
 #define writeCmdDataTmp(cmd, ...)   {               \
         const uint8_t tmp##cmd##_[] = { __VA_ARGS__ };              \
         writeCmdData(cmd, (uint8_t *) &tmp##cmd##_[0], sizeof(tmp##cmd##_));  \
@@ -127,7 +155,7 @@ void Adafruit_ILI9341::spiwrite(uint8_t c) {
 #endif
 }
 
-void Adafruit_ILI9341::spiwriteBytes(uint8_t * data, uint8_t size) {
+void Adafruit_ILI9341::spiwriteBytes(uint8_t * data, uint32_t size) {
 #ifdef ESP8266
     SPI.writeBytes(data, size);
 #else
@@ -596,6 +624,353 @@ void Adafruit_ILI9341::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint
 }
 
 
+// Draw a character of the built-in font with an opaque background as one
+// address window, sending each scaled glyph row once and letting the SPI
+// hardware repeat it for the vertical scale. Custom fonts, transparent
+// text and glyphs that are clipped take the generic per-pixel path.
+// Adafruit_GFX::drawChar() is not virtual, so print() does not get here;
+// callers that want the burst call this directly.
+void Adafruit_ILI9341::drawGlyph(int16_t x, int16_t y, unsigned char c, uint16_t color,
+                                uint16_t bg, uint8_t size_x, uint8_t size_y) {
+
+    int16_t w = 6 * size_x;
+    int16_t h = 8 * size_y;
+
+    if(gfxFont || (bg == color) || (size_x > GLYPH_MAX_SIZE) ||
+       (x < 0) || (y < 0) || (x + w > _width) || (y + h > _height)) {
+        Adafruit_GFX::drawChar(x, y, c, color, bg, size_x, size_y);
+        return;
+    }
+
+    const uint8_t * columns = glyphReader.read(c, !_cp437);
+
+    uint8_t line[GLYPH_LINE_BYTES];
+    uint8_t lineBytes = w * 2;
+
+    if(hwSPI) {
+        spi_begin();
+    }
+
+    spiCsLow();
+
+    setAddrWindow_(x, y, x + w - 1, y + h - 1);
+
+    for(int8_t j = 0; j < 8; j++) {
+        uint8_t * ptr = &line[0];
+        for(int8_t i = 0; i < 6; i++) {
+            uint16_t pixel = ((columns[i] >> j) & 1) ? color : bg;
+            for(uint8_t k = 0; k < size_x; k++) {
+                *ptr++ = pixel >> 8;
+                *ptr++ = pixel;
+            }
+        }
+        if(lineBytes <= 64) {
+            spiwritePattern(&line[0], lineBytes, size_y);
+        } else {
+            for(uint8_t k = 0; k < size_y; k++) {
+                spiwriteBytes(&line[0], lineBytes);
+            }
+        }
+    }
+
+    spiCsHigh();
+
+    if(hwSPI) {
+        spi_end();
+    }
+}
+
+
+// Send a block of pixels already in wire order (big-endian RGB565) as one
+// address window. The block must lie within the screen.
+void Adafruit_ILI9341::writePixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *bytes) {
+
+    if((x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (x + w > _width) || (y + h > _height)) {
+        return;
+    }
+
+    if(hwSPI) {
+        spi_begin();
+    }
+
+    spiCsLow();
+
+    setAddrWindow_(x, y, x + w - 1, y + h - 1);
+    spiwriteBytes((uint8_t *) bytes, (uint32_t) w * h * 2);
+
+    spiCsHigh();
+
+    if(hwSPI) {
+        spi_end();
+    }
+}
+
+// Hardware vertical scrolling works on the 320 lines of frame memory,
+// which run left to right in rotations 1 and 3. tfa and bfa lines at
+// either end stay fixed; scrollTo() picks the memory line shown first in
+// the area between. setScrollArea(0, 0) and scrollTo(0) undo scrolling.
+void Adafruit_ILI9341::setScrollArea(uint16_t tfa, uint16_t bfa) {
+    uint16_t vsa = ILI9341_TFTHEIGHT - tfa - bfa;
+    uint8_t buff[] = { (uint8_t) (tfa >> 8), (uint8_t) tfa, (uint8_t) (vsa >> 8), (uint8_t) vsa,
+                       (uint8_t) (bfa >> 8), (uint8_t) bfa };
+    if (hwSPI) spi_begin();
+    writeCmdData(ILI9341_VSCRDEF, &buff[0], sizeof(buff));
+    if (hwSPI) spi_end();
+}
+
+void Adafruit_ILI9341::scrollTo(uint16_t vsp) {
+    uint8_t buff[] = { (uint8_t) (vsp >> 8), (uint8_t) vsp };
+    if (hwSPI) spi_begin();
+    writeCmdData(ILI9341_VSCRSADD, &buff[0], sizeof(buff));
+    if (hwSPI) spi_end();
+}
+
+// Draw a run-length encoded monochrome image from PROGMEM (see
+// scripts/rle-bitmap.py) with an opaque background. The image is one address
+// window and each run a single pattern write. Clipped images are decoded
+// pixel by pixel.
+void Adafruit_ILI9341::drawRLEBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+                                     int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+
+    int32_t left = (int32_t) w * h;
+    boolean fg = false;
+
+    if((x < 0) || (y < 0) || (x + w > _width) || (y + h > _height)) {
+        int32_t i = 0;
+        while(i < left) {
+            uint8_t run = pgm_read_byte(bitmap++);
+            while(run-- && (i < left)) {
+                drawPixel(x + i % w, y + i / w, fg ? color : bg);
+                i++;
+            }
+            fg = !fg;
+        }
+        return;
+    }
+
+    uint8_t colorBin[] = { (uint8_t) (color >> 8), (uint8_t) color };
+    uint8_t bgBin[] = { (uint8_t) (bg >> 8), (uint8_t) bg };
+
+    if(hwSPI) {
+        spi_begin();
+    }
+
+    spiCsLow();
+
+    setAddrWindow_(x, y, x + w - 1, y + h - 1);
+
+    while(left > 0) {
+        int32_t run = pgm_read_byte(bitmap++);
+        if(run > left) run = left;
+        if(run) {
+            spiwritePattern(fg ? &colorBin[0] : &bgBin[0], 2, run);
+            left -= run;
+        }
+        fg = !fg;
+    }
+
+    spiCsHigh();
+
+    if(hwSPI) {
+        spi_end();
+    }
+}
+
+
+// Draw a run-length encoded image of up to four colors from RAM. Each byte
+// is one run: the top two bits index the palette and the low six bits hold
+// the run length minus one. Like drawRLEBitmap(), the image is one address
+// window with a pattern write per run, and clipped images go pixel by pixel.
+void Adafruit_ILI9341::drawIndexedRLE(int16_t x, int16_t y, const uint8_t *data,
+                                      int16_t w, int16_t h, const uint16_t *palette) {
+
+    int32_t left = (int32_t) w * h;
+
+    if((x < 0) || (y < 0) || (x + w > _width) || (y + h > _height)) {
+        int32_t i = 0;
+        while(i < left) {
+            uint8_t run = (*data & 0x3F) + 1;
+            uint16_t color = palette[*data++ >> 6];
+            while(run-- && (i < left)) {
+                drawPixel(x + i % w, y + i / w, color);
+                i++;
+            }
+        }
+        return;
+    }
+
+    uint8_t colorBin[4][2];
+    for(uint8_t i = 0; i < 4; i++) {
+        colorBin[i][0] = palette[i] >> 8;
+        colorBin[i][1] = palette[i];
+    }
+
+    if(hwSPI) {
+        spi_begin();
+    }
+
+    spiCsLow();
+
+    setAddrWindow_(x, y, x + w - 1, y + h - 1);
+
+    while(left > 0) {
+        int32_t run = (*data & 0x3F) + 1;
+        if(run > left) run = left;
+        spiwritePattern(&colorBin[*data++ >> 6][0], 2, run);
+        left -= run;
+    }
+
+    spiCsHigh();
+
+    if(hwSPI) {
+        spi_end();
+    }
+}
+
+Adafruit_ILI9341_GlyphCache::Adafruit_ILI9341_GlyphCache(const char *charset, uint16_t color,
+                                                         uint16_t bg, uint8_t size, uint8_t maxRun) {
+    _charset = charset;
+    _color   = color;
+    _bg      = bg;
+    _size    = size;
+    _maxRun  = maxRun;
+    _nGlyphs = 0;
+    _nRows   = 0;
+    _rows    = NULL;
+    _glyphs  = NULL;
+    _line    = NULL;
+}
+
+Adafruit_ILI9341_GlyphCache::~Adafruit_ILI9341_GlyphCache(void) {
+    free(_rows);
+    free(_glyphs);
+    free(_line);
+}
+
+boolean Adafruit_ILI9341_GlyphCache::contains(char c) {
+    return c && strchr(_charset, c);
+}
+
+uint16_t Adafruit_ILI9341_GlyphCache::bytesUsed(void) {
+    if(!_rows) return 0;
+    uint16_t rowBytes = 6 * _size * 2;
+    return _nRows * rowBytes + _nGlyphs * 8 + _maxRun * rowBytes;
+}
+
+// Each font row of a glyph is a 5 bit mask (the sixth, spacing column is
+// always background), so there are at most 32 distinct expanded rows.
+boolean Adafruit_ILI9341::buildGlyphCache(Adafruit_ILI9341_GlyphCache &cache) {
+
+    uint8_t slot[32];
+    memset(slot, 0xFF, sizeof(slot));
+
+    uint8_t nGlyphs = strlen(cache._charset);
+    uint8_t * glyphs = (uint8_t *) malloc(nGlyphs * 8);
+    if(!glyphs) return false;
+
+    uint8_t nRows = 0;
+    for(uint8_t g = 0; g < nGlyphs; g++) {
+        const uint8_t * columns = glyphReader.read(cache._charset[g], !_cp437);
+        for(int8_t j = 0; j < 8; j++) {
+            uint8_t mask = 0;
+            for(int8_t i = 0; i < 5; i++) {
+                mask |= ((columns[i] >> j) & 1) << i;
+            }
+            if(slot[mask] == 0xFF) slot[mask] = nRows++;
+            glyphs[g * 8 + j] = slot[mask];
+        }
+    }
+
+    uint16_t rowBytes = 6 * cache._size * 2;
+    uint8_t * rows = (uint8_t *) malloc(nRows * rowBytes);
+    uint8_t * line = (uint8_t *) malloc(cache._maxRun * rowBytes);
+    if(!rows || !line) {
+        free(glyphs);
+        free(rows);
+        free(line);
+        return false;
+    }
+
+    for(uint8_t mask = 0; mask < 32; mask++) {
+        if(slot[mask] == 0xFF) continue;
+        uint8_t * ptr = rows + slot[mask] * rowBytes;
+        for(int8_t i = 0; i < 6; i++) {
+            uint16_t pixel = ((mask >> i) & 1) ? cache._color : cache._bg;
+            for(uint8_t k = 0; k < cache._size; k++) {
+                *ptr++ = pixel >> 8;
+                *ptr++ = pixel;
+            }
+        }
+    }
+
+    cache._nGlyphs = nGlyphs;
+    cache._nRows   = nRows;
+    cache._glyphs  = glyphs;
+    cache._rows    = rows;
+    cache._line    = line;
+    return true;
+}
+
+// Draw a run of characters from a glyph cache as one address window per
+// _maxRun characters: each scanline is assembled from cached rows and sent
+// in a single burst. Characters missing from the cache, or runs that would
+// be clipped, are drawn with drawGlyph() instead.
+void Adafruit_ILI9341::drawCachedString(int16_t x, int16_t y, const char *str, uint8_t len,
+                                        Adafruit_ILI9341_GlyphCache &cache) {
+
+    uint8_t size = cache._size;
+    int16_t cellW = 6 * size;
+
+    boolean cached = (cache._rows || buildGlyphCache(cache)) &&
+                     (x >= 0) && (y >= 0) &&
+                     (x + len * cellW <= _width) && (y + 8 * size <= _height);
+    for(uint8_t i = 0; cached && (i < len); i++) {
+        cached = cache.contains(str[i]);
+    }
+    if(!cached) {
+        for(uint8_t i = 0; i < len; i++) {
+            drawGlyph(x + i * cellW, y, str[i], cache._color, cache._bg, size, size);
+        }
+        return;
+    }
+
+    uint16_t rowBytes = cellW * 2;
+
+    if(hwSPI) {
+        spi_begin();
+    }
+
+    spiCsLow();
+
+    while(len) {
+        uint8_t run = (len > cache._maxRun) ? cache._maxRun : len;
+        uint16_t lineBytes = run * rowBytes;
+
+        setAddrWindow_(x, y, x + run * cellW - 1, y + 8 * size - 1);
+
+        for(int8_t j = 0; j < 8; j++) {
+            for(uint8_t i = 0; i < run; i++) {
+                uint8_t g = strchr(cache._charset, str[i]) - cache._charset;
+                memcpy(cache._line + i * rowBytes, cache._rows + cache._glyphs[g * 8 + j] * rowBytes, rowBytes);
+            }
+            for(uint8_t k = 0; k < size; k++) {
+                spiwriteBytes(cache._line, lineBytes);
+            }
+        }
+
+        x   += run * cellW;
+        str += run;
+        len -= run;
+    }
+
+    spiCsHigh();
+
+    if(hwSPI) {
+        spi_end();
+    }
+}
+
+
 // Pass 8-bit (each) R,G,B, get back 16-bit packed color
 uint16_t Adafruit_ILI9341::color565(uint8_t r, uint8_t g, uint8_t b) {
   return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
@@ -766,4 +1141,4 @@ uint8_t Adafruit_ILI9341::readcommand8(uint8_t c, uint8_t index) {
  return r;
  }
  
- */
+ */
@@ -64,7 +64,9 @@
 #define ILI9341_RAMRD   0x2E
 
 #define ILI9341_PTLAR   0x30
+#define ILI9341_VSCRDEF 0x33
 #define ILI9341_MADCTL  0x36
+#define ILI9341_VSCRSADD 0x37
 #define ILI9341_PIXFMT  0x3A
 
 #define ILI9341_FRMCTR1 0xB1
@@ -117,11 +119,40 @@
 //#define ILI9341_USE_DIGITAL_WRITE
 //#define ILI9341_USE_NO_CS
 #ifdef ESP8266
-#define ESP_SPI_FREQ 4000000
+// The driver applies this clock at the start of every operation, so other
+// devices on the bus keep their own settings. 40 MHz (APB / 2) is beyond the
+// 10 MHz write cycle in the datasheet but works with these panels.
+#ifndef ESP_SPI_FREQ
+#define ESP_SPI_FREQ 40000000
+#endif
 //not working
 //#define ILI9341_USE_HW_CS
 #endif
 
+// Rows of the built-in font pre-expanded to RGB565 for one set of
+// characters, color, background and size. Glyphs of a 5x7 font share most of
+// their rows, so each distinct row is stored once and glyphs index into the
+// table. Built on first use by Adafruit_ILI9341::drawCachedString().
+class Adafruit_ILI9341_GlyphCache {
+
+ public:
+  Adafruit_ILI9341_GlyphCache(const char *charset, uint16_t color, uint16_t bg,
+                              uint8_t size, uint8_t maxRun = 12);
+  ~Adafruit_ILI9341_GlyphCache(void);
+  boolean  contains(char c);
+  uint16_t bytesUsed(void);
+
+ private:
+  friend class Adafruit_ILI9341;
+
+  const char *_charset;
+  uint16_t _color, _bg;
+  uint8_t  _size, _maxRun, _nGlyphs, _nRows;
+  uint8_t  *_rows;     // _nRows rows of 6 * _size pixels
+  uint8_t  *_glyphs;   // 8 row indices per glyph in _charset
+  uint8_t  *_line;     // one scanline of up to _maxRun glyphs
+};
+
 class Adafruit_ILI9341 : public Adafruit_GFX {
 
  public:
@@ -145,6 +176,18 @@ class Adafruit_ILI9341 : public Adafruit_GFX {
              uint16_t color),
            setRotation(uint8_t r),
            invertDisplay(boolean i);
+  void     drawGlyph(int16_t x, int16_t y, unsigned char c, uint16_t color,
+             uint16_t bg, uint8_t size_x, uint8_t size_y);
+  void     writePixels(int16_t x, int16_t y, int16_t w, int16_t h,
+             const uint8_t *bytes);
+  void     setScrollArea(uint16_t tfa, uint16_t bfa),
+           scrollTo(uint16_t vsp);
+  void     drawRLEBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+             int16_t w, int16_t h, uint16_t color, uint16_t bg),
+           drawIndexedRLE(int16_t x, int16_t y, const uint8_t *data,
+             int16_t w, int16_t h, const uint16_t *palette);
+  void     drawCachedString(int16_t x, int16_t y, const char *str, uint8_t len,
+             Adafruit_ILI9341_GlyphCache &cache);
   uint16_t color565(uint8_t r, uint8_t g, uint8_t b);
 
   void  commandList(uint8_t *addr);
@@ -171,18 +214,20 @@ class Adafruit_ILI9341 : public Adafruit_GFX {
 #ifdef ESP8266
   inline void spiwrite(uint8_t data);
   inline void spiwrite16(uint16_t data);
-  inline void spiwriteBytes(uint8_t * data, uint8_t size);
+  inline void spiwriteBytes(uint8_t * data, uint32_t size);
   inline void spiwritePattern(uint8_t * data, uint8_t size, uint32_t repeat);
 
   inline void setAddrWindow_(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 #else
   void spiwrite(uint8_t);
   void spiwrite16(uint16_t data);
-  void spiwriteBytes(uint8_t * data, uint8_t size);
+  void spiwriteBytes(uint8_t * data, uint32_t size);
   void spiwritePattern(uint8_t * data, uint8_t size, uint8_t repeat);
   void setAddrWindow_(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 #endif
 
+  boolean buildGlyphCache(Adafruit_ILI9341_GlyphCache &cache);
+
   inline void spiCsHigh(void);
   inline void spiCsLow(void);
   inline void spiDcHigh(void);
@@ -211,4 +256,4 @@ class Adafruit_ILI9341 : public Adafruit_GFX {
 #endif
 };
 
-#endif
+#endif
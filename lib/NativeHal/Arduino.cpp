@@ -0,0 +1,130 @@
+#include "Arduino.h"
+#include "Hal.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+GpioRegister GPOS(HIGH);
+GpioRegister GPOC(LOW);
+
+unsigned long millis(void) {
+  return (unsigned long)(uint32_t)(HalClock::nanos() / 1000000);
+}
+
+unsigned long micros(void) {
+  return (unsigned long)(uint32_t)(HalClock::nanos() / 1000);
+}
+
+void delay(unsigned long ms) {
+  HalClock::sleep((uint64_t)ms * 1000000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  HalClock::sleep((uint64_t)us * 1000);
+}
+
+void yield(void) {
+  HalClock::advance(1000);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  HalGpio::setMode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  HalGpio::write(pin, val);
+}
+
+int digitalRead(uint8_t pin) {
+  return HalGpio::read(pin);
+}
+
+int analogRead(uint8_t pin) {
+  return HalAdc::read(pin);
+}
+
+long random(long howbig) {
+  return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+void interrupts(void) {
+  HalTimer::setInterruptsEnabled(true);
+}
+
+void noInterrupts(void) {
+  HalTimer::setInterruptsEnabled(false);
+}
+
+// Length of a timer 1 tick in ps for the divider setting, and whether the
+// timer reloads
+
+static uint32_t timer1TickPs = 12500;
+static bool timer1Reload = false;
+
+void timer1_attachInterrupt(timercallback userFunc) {
+  HalTimer::attach(userFunc);
+}
+
+void timer1_detachInterrupt(void) {
+  HalTimer::disarm();
+  HalTimer::attach(NULL);
+}
+
+void timer1_enable(uint8_t divider, uint8_t int_type, uint8_t reload) {
+  static const uint32_t tickPs[] = { 12500, 200000, 200000, 3200000 };
+  timer1TickPs = tickPs[divider & 3];
+  timer1Reload = reload == TIM_LOOP;
+}
+
+void timer1_disable(void) {
+  HalTimer::disarm();
+}
+
+void timer1_write(uint32_t ticks) {
+  HalTimer::arm((uint64_t)(ticks & 0x7FFFFF) * timer1TickPs / 1000, timer1Reload);
+}
+
+void configTime(int timezone, int daylightOffset_sec, const char *server1,
+                const char *server2, const char *server3) {
+  // The host clock is already synchronized
+}
+
+GpioRegister &GpioRegister::operator=(uint32_t mask) {
+  for (uint8_t pin = 0; pin < HAL_GPIO_PINS; pin++) {
+    if (mask & (1UL << pin)) {
+      HalGpio::write(pin, level);
+    }
+  }
+  return *this;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (!quiet) fputc(c, stdout);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (!quiet) fwrite(buffer, 1, size, stdout);
+  return size;
+}
+
+void EspClass::reset() {
+  printf("\n*** ESP.reset() ***\n");
+  exit(0);
+}
+
+void EspClass::restart() {
+  printf("\n*** ESP.restart() ***\n");
+  exit(0);
+}
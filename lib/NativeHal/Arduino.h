@@ -0,0 +1,133 @@
+// ESP8266 Arduino core API for the native build, backed by Hal.h
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+
+#include "pgmspace.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "pins_arduino.h"
+
+using std::min;
+using std::max;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define NOT_A_PIN -1
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bit(b) (1UL << (b))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+void interrupts(void);
+void noInterrupts(void);
+
+// Timer 1, clocked at 80 MHz through a divider
+
+#define TIM_DIV1 0
+#define TIM_DIV16 1
+#define TIM_DIV256 3
+#define TIM_EDGE 0
+#define TIM_LEVEL 1
+#define TIM_SINGLE 0
+#define TIM_LOOP 1
+
+typedef void (*timercallback)(void);
+
+void timer1_attachInterrupt(timercallback userFunc);
+void timer1_detachInterrupt(void);
+void timer1_enable(uint8_t divider, uint8_t int_type, uint8_t reload);
+void timer1_disable(void);
+void timer1_write(uint32_t ticks);
+
+void configTime(int timezone, int daylightOffset_sec, const char *server1,
+                const char *server2 = nullptr, const char *server3 = nullptr);
+
+// GPIO set/clear registers, as written by drivers doing fast pin I/O
+
+class GpioRegister {
+public:
+  explicit GpioRegister(uint8_t level) : level(level) {}
+  GpioRegister &operator=(uint32_t mask);
+private:
+  uint8_t level;
+};
+
+extern GpioRegister GPOS;
+extern GpioRegister GPOC;
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) {}
+  void setQuiet(bool quiet) { this->quiet = quiet; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+private:
+  bool quiet = false;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  void reset();
+  void restart();
+  uint32_t getFreeHeap() { return 40000; }
+  uint32_t getChipId() { return 0x00c0ffee; }
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef _CERTSTORE_BEARSSL_H
+#define _CERTSTORE_BEARSSL_H
+
+#include <FS.h>
+
+namespace BearSSL {
+
+class CertStore {
+public:
+  int initCertStore(fs::FS &fs, const char *indexFileName, const char *dataFileName);
+};
+
+}
+
+#endif
@@ -0,0 +1,32 @@
+// HTTP(S) client answering from the responses registered with HalNet
+
+#ifndef ESP8266HTTPClient_H_
+#define ESP8266HTTPClient_H_
+
+#include <ESP8266WiFi.h>
+
+#define HTTPC_ERROR_CONNECTION_FAILED (-1)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+
+typedef enum {
+  HTTP_CODE_OK = 200,
+  HTTP_CODE_BAD_REQUEST = 400,
+  HTTP_CODE_UNAUTHORIZED = 401,
+  HTTP_CODE_NOT_FOUND = 404,
+  HTTP_CODE_GONE = 410,
+  HTTP_CODE_INTERNAL_SERVER_ERROR = 500
+} t_http_codes;
+
+class HTTPClient {
+public:
+  bool begin(WiFiClient &client, const String &url);
+  void end() {}
+  int GET();
+  String getString() { return payload; }
+  static String errorToString(int error);
+private:
+  String url;
+  String payload;
+};
+
+#endif
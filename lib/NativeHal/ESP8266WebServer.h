@@ -0,0 +1,28 @@
+// Configuration web server. The native build does not listen on a socket;
+// handlers are registered so the access point flow runs unmodified.
+
+#ifndef ESP8266WEBSERVER_H
+#define ESP8266WEBSERVER_H
+
+#include <functional>
+#include <map>
+#include <ESP8266WiFi.h>
+
+class ESP8266WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit ESP8266WebServer(int port = 80) : port(port) {}
+  void begin();
+  void handleClient() {}
+  void on(const String &uri, THandlerFunction handler) { handlers[uri.str()] = handler; }
+  void send(int code, const char *contentType = NULL, const String &content = String());
+  bool hasArg(const String &name) const { return args.count(name.str()) > 0; }
+  String arg(const String &name) const;
+private:
+  int port;
+  std::map<std::string, THandlerFunction> handlers;
+  std::map<std::string, std::string> args;
+};
+
+#endif
@@ -0,0 +1,55 @@
+// Simulated WiFi station and soft AP
+
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7
+} wl_status_t;
+
+class IPAddress : public Printable {
+public:
+  IPAddress() : bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+  uint8_t operator[](int index) const { return bytes[index]; }
+  String toString() const;
+  size_t printTo(Print &p) const override { return p.print(toString()); }
+private:
+  uint8_t bytes[4];
+};
+
+class WiFiClient {
+public:
+  virtual ~WiFiClient() {}
+};
+
+class ESP8266WiFiClass {
+public:
+  wl_status_t begin(const char *ssid, const char *passphrase = NULL);
+  wl_status_t begin(const String &ssid, const String &passphrase = emptyString) {
+    return begin(ssid.c_str(), passphrase.c_str());
+  }
+  wl_status_t status();
+  bool disconnect(bool wifioff = false);
+  String macAddress();
+  IPAddress localIP();
+  bool softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet);
+  bool softAP(const char *ssid, const char *passphrase = NULL);
+private:
+  bool connecting = false;
+  unsigned long beginMillis = 0;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,59 @@
+// LittleFS-style filesystem backed by a host directory (see HalFs)
+
+#ifndef FS_H
+#define FS_H
+
+#include <memory>
+#include <Arduino.h>
+
+namespace fs {
+
+class FileImpl;
+
+class File : public Stream {
+public:
+  File() {}
+  explicit File(std::shared_ptr<FileImpl> impl, const char *name) : impl(impl), fileName(name) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override;
+  using Print::write;
+
+  size_t read(uint8_t *buf, size_t size);
+  bool seek(uint32_t pos);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  const char *name() const { return fileName.c_str(); }
+  operator bool() const { return (bool)impl; }
+
+private:
+  std::shared_ptr<FileImpl> impl;
+  String fileName;
+};
+
+class FS {
+public:
+  bool begin();
+  void end() {}
+  bool format();
+  File open(const char *path, const char *mode);
+  File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+  bool exists(const char *path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  bool remove(const char *path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char *pathFrom, const char *pathTo);
+  bool mkdir(const char *path);
+};
+
+}
+
+using fs::FS;
+using fs::File;
+
+#endif
@@ -0,0 +1,63 @@
+#include "Firebase.h"
+#include "Hal.h"
+
+Firebase_ESP_Client Firebase;
+
+bool MultiPathStream::get(const String &path) {
+  FirebaseJson json;
+  FirebaseJsonData result;
+  json.setJsonData(payload);
+  if (!json.get(result, path)) return false;
+  dataPath = path;
+  value = result.stringValue;
+  type = result.type;
+  return true;
+}
+
+bool FB_RTDB::write(FirebaseData *fbdo, const String &path, const String &json, bool async) {
+  if (WiFi.status() != WL_CONNECTED) {
+    fbdo->code = -4;
+    fbdo->error = "not connected";
+    return false;
+  }
+  HalNet::rtdbWrite(path.str(), json.str(), async);
+  fbdo->code = 200;
+  fbdo->error = "";
+  return true;
+}
+
+void FB_RTDB::setMultiPathStreamCallback(FirebaseData *fbdo, MultiPathStreamEventCallback dataAvailableCallback,
+                                         StreamTimeoutCallback timeoutCallback, size_t streamTaskStackSize) {
+  streamData = fbdo;
+  streamCallback = dataAvailableCallback;
+}
+
+bool FB_RTDB::beginMultiPathStream(FirebaseData *fbdo, const String &parentPath) {
+  streamPath = parentPath;
+  return true;
+}
+
+void Firebase_ESP_Client::begin(FirebaseConfig *config, FirebaseAuth *auth) {
+  started = true;
+}
+
+void Firebase_ESP_Client::setIdToken(FirebaseConfig *config, const char *idToken, size_t expire,
+                                     const char *refreshToken) {
+}
+
+// Stream events are delivered from ready(), which the firmware polls
+
+bool Firebase_ESP_Client::ready() {
+  if (!started || WiFi.status() != WL_CONNECTED) return false;
+  std::string path, json;
+  while (RTDB.streamCallback && HalNet::nextInput(path, json)) {
+    FirebaseJson value, payload;
+    value.setJsonData(String(json));
+    payload.set(String(path), value);
+    MultiPathStream event;
+    event.eventType = "patch";
+    event.payload = payload.raw();
+    RTDB.streamCallback(event);
+  }
+  return true;
+}
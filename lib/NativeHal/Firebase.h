@@ -0,0 +1,100 @@
+// Firebase RTDB client backed by the in-memory database in HalNet
+
+#ifndef FIREBASE_H
+#define FIREBASE_H
+
+#include <functional>
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "json/FirebaseJson.h"
+
+#define FIREBASE_CLIENT_VERSION "2.7.0-native"
+
+struct token_info_t {
+  int type;
+  int status;
+  String error;
+};
+typedef struct token_info_t TokenInfo;
+typedef void (*TokenStatusCallback)(TokenInfo);
+
+struct FirebaseAuth {
+};
+
+struct FirebaseConfig {
+  String api_key;
+  String database_url;
+  TokenStatusCallback token_status_callback = NULL;
+  int max_token_generation_retry = 0;
+};
+
+class FirebaseData {
+public:
+  String errorReason() { return error; }
+  int httpCode() { return code; }
+  void setBSSLBufferSize(int rx, int tx) {}
+private:
+  friend class FB_RTDB;
+  friend class Firebase_ESP_Client;
+  String error;
+  int code = 0;
+};
+
+class MultiPathStream {
+public:
+  bool get(const String &path);
+  int payloadLength() { return payload.length(); }
+  int maxPayloadLength() { return payload.length(); }
+
+  String dataPath;
+  String value;
+  String type;
+  String eventType;
+private:
+  friend class Firebase_ESP_Client;
+  String payload;
+};
+
+typedef std::function<void(MultiPathStream)> MultiPathStreamEventCallback;
+typedef std::function<void(bool)> StreamTimeoutCallback;
+
+class FB_RTDB {
+public:
+  bool setInt(FirebaseData *fbdo, const String &path, int value) { return write(fbdo, path, String(value), false); }
+  bool setIntAsync(FirebaseData *fbdo, const String &path, int value) { return write(fbdo, path, String(value), true); }
+  bool setFloat(FirebaseData *fbdo, const String &path, float value) { return write(fbdo, path, String(value, 6), false); }
+  bool setFloatAsync(FirebaseData *fbdo, const String &path, float value) { return write(fbdo, path, String(value, 6), true); }
+  bool setDouble(FirebaseData *fbdo, const String &path, double value) { return write(fbdo, path, String(value, 9), false); }
+  bool setDoubleAsync(FirebaseData *fbdo, const String &path, double value) { return write(fbdo, path, String(value, 9), true); }
+  bool updateNode(FirebaseData *fbdo, const String &path, FirebaseJson *json) { return write(fbdo, path, json->raw(), false); }
+  bool updateNodeAsync(FirebaseData *fbdo, const String &path, FirebaseJson *json) { return write(fbdo, path, json->raw(), true); }
+
+  void setMultiPathStreamCallback(FirebaseData *fbdo, MultiPathStreamEventCallback dataAvailableCallback,
+                                  StreamTimeoutCallback timeoutCallback = NULL, size_t streamTaskStackSize = 8192);
+  bool beginMultiPathStream(FirebaseData *fbdo, const String &parentPath);
+
+private:
+  friend class Firebase_ESP_Client;
+  bool write(FirebaseData *fbdo, const String &path, const String &json, bool async);
+
+  FirebaseData *streamData = NULL;
+  MultiPathStreamEventCallback streamCallback;
+  String streamPath;
+};
+
+class Firebase_ESP_Client {
+public:
+  FB_RTDB RTDB;
+
+  void begin(FirebaseConfig *config, FirebaseAuth *auth);
+  void reconnectWiFi(bool reconnect) {}
+  void setIdToken(FirebaseConfig *config, const char *idToken, size_t expire = 3600, const char *refreshToken = "");
+  bool ready();
+
+private:
+  bool started = false;
+};
+
+extern Firebase_ESP_Client Firebase;
+
+#endif
@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+
+#include "Hal.h"
+
+// Clock
+
+// Cost of reading the clock in virtual mode, so busy-wait loops progress
+#define CLOCK_READ_NS 250
+
+static bool realtime = false;
+static uint64_t virtualNs = 0;
+static std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+static void (*sleepHook)(void) = NULL;
+static bool inSleepHook = false;
+
+void HalClock::setRealtime(bool rt) {
+  realtime = rt;
+  bootTime = std::chrono::steady_clock::now();
+}
+
+bool HalClock::isRealtime() {
+  return realtime;
+}
+
+uint64_t HalClock::peekNanos() {
+  if (realtime) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - bootTime).count();
+  }
+  return virtualNs;
+}
+
+uint64_t HalClock::nanos() {
+  advance(CLOCK_READ_NS);
+  return peekNanos();
+}
+
+// Timer callbacks due along the way run at their own time, then the clock
+// moves on to the end of the interval
+
+void HalClock::advance(uint64_t ns) {
+  if (realtime) {
+    HalTimer::runDue(peekNanos());
+    return;
+  }
+  uint64_t target = virtualNs + ns;
+  HalTimer::runDue(target);
+  if (virtualNs < target) virtualNs = target;
+}
+
+void HalClock::sleep(uint64_t ns) {
+  if (realtime) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+  }
+  advance(ns);
+  if (sleepHook && !inSleepHook) {
+    inSleepHook = true;
+    sleepHook();
+    inSleepHook = false;
+  }
+}
+
+void HalClock::setSleepHook(void (*hook)(void)) {
+  sleepHook = hook;
+}
+
+// Timer
+
+static HalTimerCallback timerCallback = NULL;
+static bool timerArmed = false;
+static bool timerReload = false;
+static bool inTimerCallback = false;
+static bool interruptsEnabled = true;
+static uint64_t timerDeadline = 0;
+static uint64_t timerPeriod = 0;
+static uint32_t timerFired = 0;
+static uint64_t timerMaxLatency = 0;
+
+void HalTimer::attach(HalTimerCallback callback) {
+  timerCallback = callback;
+}
+
+void HalTimer::arm(uint64_t delayNs, bool reload) {
+  timerDeadline = HalClock::peekNanos() + delayNs;
+  timerPeriod = delayNs;
+  timerReload = reload;
+  timerArmed = true;
+}
+
+void HalTimer::disarm() {
+  timerArmed = false;
+}
+
+void HalTimer::setInterruptsEnabled(bool enabled) {
+  interruptsEnabled = enabled;
+  if (enabled) runDue(HalClock::peekNanos());
+}
+
+void HalTimer::runDue(uint64_t now) {
+  while (timerArmed && timerCallback && interruptsEnabled && !inTimerCallback &&
+         timerDeadline <= now) {
+    if (!realtime && virtualNs < timerDeadline) virtualNs = timerDeadline;
+    uint64_t latency = HalClock::peekNanos() - timerDeadline;
+    if (latency > timerMaxLatency) timerMaxLatency = latency;
+    if (timerReload) {
+      timerDeadline += timerPeriod;
+    } else {
+      timerArmed = false;
+    }
+    inTimerCallback = true;
+    timerCallback();
+    inTimerCallback = false;
+    timerFired++;
+  }
+}
+
+uint32_t HalTimer::fired() {
+  return timerFired;
+}
+
+uint64_t HalTimer::maxLatencyNs() {
+  return timerMaxLatency;
+}
+
+// GPIO
+
+#define MAX_PIN_LISTENERS 16
+#define PIN_MODE_OUTPUT 0x01
+#define PIN_MODE_INPUT_PULLUP 0x02
+
+struct PinState {
+  uint8_t mode;
+  uint8_t latch;
+  bool driven;
+  uint8_t level;
+  uint32_t edges;
+};
+
+struct PinListener {
+  uint8_t pin;
+  HalPinListener fn;
+  void *ctx;
+};
+
+static PinState pins[HAL_GPIO_PINS];
+static PinListener listeners[MAX_PIN_LISTENERS];
+static int nListeners = 0;
+
+static void notify(uint8_t pin, uint8_t level) {
+  for (int i = 0; i < nListeners; i++) {
+    if (listeners[i].pin == pin) {
+      listeners[i].fn(pin, level, listeners[i].ctx);
+    }
+  }
+}
+
+void HalGpio::setMode(uint8_t pin, uint8_t mode) {
+  if (pin >= HAL_GPIO_PINS) return;
+  pins[pin].mode = mode;
+}
+
+void HalGpio::write(uint8_t pin, uint8_t level) {
+  if (pin >= HAL_GPIO_PINS) return;
+  level = level ? 1 : 0;
+  if (pins[pin].latch != level) {
+    pins[pin].latch = level;
+    pins[pin].edges++;
+  }
+  notify(pin, level);
+}
+
+int HalGpio::read(uint8_t pin) {
+  if (pin >= HAL_GPIO_PINS) return 0;
+  PinState &p = pins[pin];
+  if (p.mode == PIN_MODE_OUTPUT) return p.latch;
+  if (p.driven) return p.level;
+  return p.mode == PIN_MODE_INPUT_PULLUP ? 1 : 0;
+}
+
+void HalGpio::drive(uint8_t pin, uint8_t level) {
+  if (pin >= HAL_GPIO_PINS) return;
+  pins[pin].driven = true;
+  pins[pin].level = level ? 1 : 0;
+}
+
+void HalGpio::release(uint8_t pin) {
+  if (pin >= HAL_GPIO_PINS) return;
+  pins[pin].driven = false;
+}
+
+bool HalGpio::addListener(uint8_t pin, HalPinListener listener, void *ctx) {
+  if (pin >= HAL_GPIO_PINS || nListeners >= MAX_PIN_LISTENERS) return false;
+  listeners[nListeners++] = { pin, listener, ctx };
+  return true;
+}
+
+uint32_t HalGpio::edges(uint8_t pin) {
+  return pin < HAL_GPIO_PINS ? pins[pin].edges : 0;
+}
+
+// SPI bus
+
+#define MAX_SPI_DEVICES 4
+
+struct SpiSlot {
+  uint8_t cs;
+  SpiDevice *device;
+  const char *name;
+  bool selected;
+  SpiDeviceStats stats;
+};
+
+static SpiSlot slots[MAX_SPI_DEVICES];
+static int nSlots = 0;
+static uint32_t busHz = 4000000;
+static uint8_t busMode = 0;
+static uint64_t orphanBytes = 0;
+
+static void csChanged(uint8_t pin, uint8_t level, void *ctx) {
+  SpiSlot *slot = (SpiSlot *)ctx;
+  if (level == 0 && !slot->selected) {
+    slot->selected = true;
+    slot->stats.transactions++;
+    slot->device->select();
+  } else if (level != 0 && slot->selected) {
+    slot->selected = false;
+    slot->device->deselect();
+  }
+}
+
+bool HalSpi::attach(uint8_t cs, SpiDevice *device, const char *name) {
+  if (nSlots >= MAX_SPI_DEVICES) return false;
+  SpiSlot &slot = slots[nSlots++];
+  slot.cs = cs;
+  slot.device = device;
+  slot.name = name;
+  slot.selected = false;
+  slot.stats = SpiDeviceStats();
+  return HalGpio::addListener(cs, csChanged, &slot);
+}
+
+uint8_t HalSpi::transfer(uint8_t out) {
+  uint64_t ns = 8000000000ULL / busHz;
+  HalClock::advance(ns);
+  int selected = 0;
+  for (int i = 0; i < nSlots; i++) {
+    if (slots[i].selected) selected++;
+  }
+  if (selected == 0) {
+    orphanBytes++;
+    return 0xFF;
+  }
+  uint8_t in = 0xFF;
+  for (int i = 0; i < nSlots; i++) {
+    SpiSlot &slot = slots[i];
+    if (!slot.selected) continue;
+    slot.stats.bytes++;
+    slot.stats.busNs += ns;
+    if (selected > 1) slot.stats.conflicts++;
+    if (busHz > slot.device->maxFrequency()) slot.stats.overclocked++;
+    if (!slot.device->acceptsMode(busMode)) slot.stats.wrongMode++;
+    in &= slot.device->transfer(out);
+  }
+  return in;
+}
+
+void HalSpi::setFrequency(uint32_t hz) {
+  if (hz > 0) busHz = hz;
+}
+
+uint32_t HalSpi::frequency() {
+  return busHz;
+}
+
+void HalSpi::setMode(uint8_t mode) {
+  busMode = mode;
+}
+
+uint8_t HalSpi::mode() {
+  return busMode;
+}
+
+const SpiDeviceStats *HalSpi::stats(uint8_t cs) {
+  for (int i = 0; i < nSlots; i++) {
+    if (slots[i].cs == cs) return &slots[i].stats;
+  }
+  return NULL;
+}
+
+uint32_t HalSpi::violations() {
+  uint32_t n = 0;
+  for (int i = 0; i < nSlots; i++) {
+    n += slots[i].stats.conflicts + slots[i].stats.overclocked + slots[i].stats.wrongMode;
+  }
+  return n;
+}
+
+void HalSpi::report() {
+  printf("SPI bus:\n");
+  for (int i = 0; i < nSlots; i++) {
+    SpiSlot &slot = slots[i];
+    printf("  %-10s cs %2d: %10llu bytes %8u transactions %8.1f ms bus time, %u conflicts, %u overclocked, %u wrong mode\n",
+           slot.name, slot.cs, (unsigned long long)slot.stats.bytes, slot.stats.transactions,
+           slot.stats.busNs / 1e6, slot.stats.conflicts, slot.stats.overclocked, slot.stats.wrongMode);
+  }
+  if (orphanBytes) {
+    printf("  %llu bytes clocked with no device selected\n", (unsigned long long)orphanBytes);
+  }
+}
+
+// ADC
+
+#define ADC_CHANNELS 1
+
+static int adcValues[ADC_CHANNELS];
+
+void HalAdc::set(uint8_t pin, int value) {
+  uint8_t channel = pin >= HAL_GPIO_PINS ? pin - HAL_GPIO_PINS : 0;
+  if (channel >= ADC_CHANNELS) return;
+  if (value < 0) value = 0;
+  if (value > 1023) value = 1023;
+  adcValues[channel] = value;
+}
+
+int HalAdc::read(uint8_t pin) {
+  uint8_t channel = pin >= HAL_GPIO_PINS ? pin - HAL_GPIO_PINS : 0;
+  HalClock::advance(100000);  // ~100 us conversion on the ESP8266
+  return channel < ADC_CHANNELS ? adcValues[channel] : 0;
+}
+
+// Filesystem
+
+static std::string fsRoot = "data";
+
+void HalFs::setRoot(const char *dir) {
+  fsRoot = dir;
+  while (fsRoot.size() > 1 && fsRoot[fsRoot.size() - 1] == '/') {
+    fsRoot.erase(fsRoot.size() - 1);
+  }
+}
+
+std::string HalFs::path(const char *name) {
+  std::string p = fsRoot;
+  if (name[0] != '/') p += '/';
+  return p + name;
+}
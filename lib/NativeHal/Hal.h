@@ -0,0 +1,142 @@
+// Hardware abstraction layer for the native (Linux) build.
+//
+// The Arduino core headers in this library (Arduino.h, SPI.h, LittleFS.h,
+// ESP8266WiFi.h, Firebase.h, ...) are thin shims over the classes below,
+// which hold the simulated state of the board: clock, GPIO, SPI bus, ADC,
+// filesystem and network. Device models (SimMax31865, SimXpt2046, ...)
+// attach to the SPI bus and GPIO pins so the real drivers run unmodified.
+
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Simulated time. In virtual mode (the default) time only moves when the
+// firmware waits, reads the clock or clocks bytes over the SPI bus, so runs
+// are deterministic and much faster than real time. In realtime mode the
+// clock follows the host's monotonic clock. The sleep hook runs after every
+// delay, so the simulator can act while the firmware blocks.
+
+class HalClock {
+public:
+  static void setRealtime(bool realtime);
+  static bool isRealtime();
+  static uint64_t nanos();
+  static uint64_t peekNanos();
+  static void advance(uint64_t ns);
+  static void sleep(uint64_t ns);
+  static void setSleepHook(void (*hook)(void));
+};
+
+// Hardware timer 1. The callback runs at the simulated time the timer
+// expires, from whichever clock advance crosses it. While interrupts are
+// disabled it is held back and runs as soon as they are enabled again; the
+// longest such delay is reported as the interrupt latency.
+
+typedef void (*HalTimerCallback)(void);
+
+class HalTimer {
+public:
+  static void attach(HalTimerCallback callback);
+  static void arm(uint64_t delayNs, bool reload);
+  static void disarm();
+  static void setInterruptsEnabled(bool enabled);
+  static void runDue(uint64_t now);
+  static uint32_t fired();
+  static uint64_t maxLatencyNs();
+};
+
+// GPIO pins 0-16. Outputs keep a latch; inputs read whatever a device
+// model drives onto the pin, or the pull-up level if nothing does.
+// Listeners are called on every write, including ones that leave the
+// latch unchanged.
+
+#define HAL_GPIO_PINS 17
+
+typedef void (*HalPinListener)(uint8_t pin, uint8_t level, void *ctx);
+
+class HalGpio {
+public:
+  static void setMode(uint8_t pin, uint8_t mode);
+  static void write(uint8_t pin, uint8_t level);
+  static int read(uint8_t pin);
+  static void drive(uint8_t pin, uint8_t level);
+  static void release(uint8_t pin);
+  static bool addListener(uint8_t pin, HalPinListener listener, void *ctx);
+  static uint32_t edges(uint8_t pin);
+};
+
+// Shared SPI bus. A device is selected while its chip select pin is low;
+// every byte clocked on the bus is delivered to the selected device and
+// costs 8 bit times of simulated time at the current bus frequency. Bytes
+// clocked while several devices are selected, above a device's maximum
+// clock or in a mode it can't sample are counted as violations.
+
+class SpiDevice {
+public:
+  virtual ~SpiDevice() {}
+  virtual void select() {}
+  virtual uint8_t transfer(uint8_t out) = 0;
+  virtual void deselect() {}
+  virtual uint32_t maxFrequency() const { return 80000000; }
+  virtual bool acceptsMode(uint8_t mode) const { return true; }
+};
+
+struct SpiDeviceStats {
+  uint64_t bytes;
+  uint32_t transactions;
+  uint32_t conflicts;
+  uint32_t overclocked;
+  uint32_t wrongMode;
+  uint64_t busNs;
+};
+
+class HalSpi {
+public:
+  static bool attach(uint8_t cs, SpiDevice *device, const char *name);
+  static uint8_t transfer(uint8_t out);
+  static void setFrequency(uint32_t hz);
+  static uint32_t frequency();
+  static void setMode(uint8_t mode);
+  static uint8_t mode();
+  static const SpiDeviceStats *stats(uint8_t cs);
+  static uint32_t violations();
+  static void report();
+};
+
+// ADC. The ESP8266 has one channel (A0) returning 0-1023.
+
+class HalAdc {
+public:
+  static void set(uint8_t pin, int value);
+  static int read(uint8_t pin);
+};
+
+// LittleFS is mapped onto a host directory.
+
+class HalFs {
+public:
+  static void setRoot(const char *dir);
+  static std::string path(const char *name);
+};
+
+// WiFi, HTTPS and Firebase RTDB. Requests cost simulated time to model the
+// blocking TLS round trips of the real client.
+
+class HalNet {
+public:
+  static void setWifiAvailable(bool available);
+  static bool wifiAvailable();
+  static void setRequestCost(uint32_t asyncMs, uint32_t syncMs);
+  static void setHttpResponse(const char *url, int code, const char *body);
+  static int httpGet(const std::string &url, std::string &body);
+  static void rtdbWrite(const std::string &path, const std::string &json, bool async);
+  static std::string rtdbRead(const std::string &path);
+  static void queueInput(uint32_t atMs, const std::string &path, const std::string &json);
+  static bool nextInput(std::string &path, std::string &json);
+  static void report();
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "LittleFS.h"
+#include "Hal.h"
+
+fs::FS LittleFS;
+
+namespace fs {
+
+class FileImpl {
+public:
+  explicit FileImpl(FILE *f) : f(f) {}
+  ~FileImpl() { if (f) fclose(f); }
+  FILE *f;
+};
+
+static bool makeParents(const std::string &path) {
+  for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+    std::string dir = path.substr(0, pos);
+    if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+  }
+  return true;
+}
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  if (!impl || !impl->f) return 0;
+  return fwrite(buf, 1, size, impl->f);
+}
+
+int File::available() {
+  if (!impl || !impl->f) return 0;
+  return (int)(size() - position());
+}
+
+int File::read() {
+  if (!impl || !impl->f) return -1;
+  return fgetc(impl->f);
+}
+
+int File::peek() {
+  if (!impl || !impl->f) return -1;
+  int c = fgetc(impl->f);
+  if (c != EOF) ungetc(c, impl->f);
+  return c;
+}
+
+void File::flush() {
+  if (impl && impl->f) fflush(impl->f);
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+  if (!impl || !impl->f) return 0;
+  return fread(buf, 1, size, impl->f);
+}
+
+bool File::seek(uint32_t pos) {
+  return impl && impl->f && fseek(impl->f, pos, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+  if (!impl || !impl->f) return 0;
+  long pos = ftell(impl->f);
+  return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+  if (!impl || !impl->f) return 0;
+  struct stat st;
+  fflush(impl->f);
+  return fstat(fileno(impl->f), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+  impl.reset();
+}
+
+bool FS::begin() {
+  struct stat st;
+  std::string root = HalFs::path("");
+  return stat(root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool FS::format() {
+  return false;
+}
+
+File FS::open(const char *path, const char *mode) {
+  std::string hostPath = HalFs::path(path);
+  if (mode[0] != 'r') makeParents(hostPath);
+  FILE *f = fopen(hostPath.c_str(), mode);
+  if (!f) return File();
+  return File(std::make_shared<FileImpl>(f), path);
+}
+
+bool FS::exists(const char *path) {
+  struct stat st;
+  return stat(HalFs::path(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) {
+  return ::remove(HalFs::path(path).c_str()) == 0;
+}
+
+bool FS::rename(const char *pathFrom, const char *pathTo) {
+  return ::rename(HalFs::path(pathFrom).c_str(), HalFs::path(pathTo).c_str()) == 0;
+}
+
+bool FS::mkdir(const char *path) {
+  return ::mkdir(HalFs::path(path).c_str(), 0755) == 0;
+}
+
+}
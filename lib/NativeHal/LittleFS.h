@@ -0,0 +1,8 @@
+#ifndef __LITTLEFS_H
+#define __LITTLEFS_H
+
+#include <FS.h>
+
+extern fs::FS LittleFS;
+
+#endif
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <deque>
+#include <map>
+
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+#include <ESP8266WebServer.h>
+#include <CertStoreBearSSL.h>
+#include "Hal.h"
+
+// Simulated time for the station to associate and get a DHCP lease
+#define WIFI_CONNECT_MS 1500
+
+ESP8266WiFiClass WiFi;
+
+struct HttpResponse {
+  int code;
+  std::string body;
+};
+
+struct StreamInput {
+  uint32_t atMs;
+  std::string path;
+  std::string json;
+};
+
+static bool wifiInRange = true;
+static uint32_t asyncCostMs = 20;
+static uint32_t syncCostMs = 150;
+static std::map<std::string, HttpResponse> httpResponses;
+static std::map<std::string, std::string> rtdb;
+static std::deque<StreamInput> inputs;
+static uint32_t rtdbWrites = 0;
+static uint32_t rtdbAsyncWrites = 0;
+static uint64_t rtdbBytes = 0;
+static uint32_t httpRequests = 0;
+
+// HalNet
+
+void HalNet::setWifiAvailable(bool available) {
+  wifiInRange = available;
+}
+
+bool HalNet::wifiAvailable() {
+  return wifiInRange;
+}
+
+void HalNet::setRequestCost(uint32_t asyncMs, uint32_t syncMs) {
+  asyncCostMs = asyncMs;
+  syncCostMs = syncMs;
+}
+
+void HalNet::setHttpResponse(const char *url, int code, const char *body) {
+  httpResponses[url] = { code, body };
+}
+
+int HalNet::httpGet(const std::string &url, std::string &body) {
+  httpRequests++;
+  HalClock::sleep((uint64_t)syncCostMs * 1000000);
+  std::string base = url.substr(0, url.find('?'));
+  std::map<std::string, HttpResponse>::iterator it = httpResponses.find(base);
+  if (it == httpResponses.end()) return HTTPC_ERROR_CONNECTION_FAILED;
+  body = it->second.body;
+  return it->second.code;
+}
+
+void HalNet::rtdbWrite(const std::string &path, const std::string &json, bool async) {
+  HalClock::sleep((uint64_t)(async ? asyncCostMs : syncCostMs) * 1000000);
+  rtdb[path] = json;
+  rtdbWrites++;
+  if (async) rtdbAsyncWrites++;
+  rtdbBytes += path.size() + json.size();
+}
+
+std::string HalNet::rtdbRead(const std::string &path) {
+  std::map<std::string, std::string>::iterator it = rtdb.find(path);
+  return it == rtdb.end() ? "null" : it->second;
+}
+
+void HalNet::queueInput(uint32_t atMs, const std::string &path, const std::string &json) {
+  std::deque<StreamInput>::iterator it = inputs.begin();
+  while (it != inputs.end() && it->atMs <= atMs) it++;
+  inputs.insert(it, { atMs, path, json });
+}
+
+bool HalNet::nextInput(std::string &path, std::string &json) {
+  if (inputs.empty() || (int32_t)(millis() - inputs.front().atMs) < 0) return false;
+  path = inputs.front().path;
+  json = inputs.front().json;
+  inputs.pop_front();
+  return true;
+}
+
+void HalNet::report() {
+  printf("Network:\n");
+  printf("  %u RTDB writes (%u async), %llu payload bytes, %u HTTP requests\n",
+         rtdbWrites, rtdbAsyncWrites, (unsigned long long)rtdbBytes, httpRequests);
+}
+
+// WiFi
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+  return buf;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *passphrase) {
+  connecting = true;
+  beginMillis = millis();
+  return status();
+}
+
+wl_status_t ESP8266WiFiClass::status() {
+  if (!connecting) return WL_DISCONNECTED;
+  if (!HalNet::wifiAvailable()) return WL_NO_SSID_AVAIL;
+  return millis() - beginMillis >= WIFI_CONNECT_MS ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifioff) {
+  connecting = false;
+  return true;
+}
+
+String ESP8266WiFiClass::macAddress() {
+  return "5C:CF:7F:00:00:01";
+}
+
+IPAddress ESP8266WiFiClass::localIP() {
+  return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+bool ESP8266WiFiClass::softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet) {
+  return true;
+}
+
+bool ESP8266WiFiClass::softAP(const char *ssid, const char *passphrase) {
+  printf("[sim] soft AP \"%s\" password \"%s\"\n", ssid, passphrase ? passphrase : "");
+  return true;
+}
+
+// HTTP client
+
+bool HTTPClient::begin(WiFiClient &client, const String &url) {
+  this->url = url;
+  return true;
+}
+
+int HTTPClient::GET() {
+  if (WiFi.status() != WL_CONNECTED) return HTTPC_ERROR_NOT_CONNECTED;
+  std::string body;
+  int code = HalNet::httpGet(url.str(), body);
+  payload = String(body);
+  return code;
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_FAILED:
+      return "connection failed";
+    case HTTPC_ERROR_NOT_CONNECTED:
+      return "not connected";
+    default:
+      return "";
+  }
+}
+
+// Web server
+
+void ESP8266WebServer::begin() {
+  printf("[sim] web server registered %u handlers on port %d (not listening)\n",
+         (unsigned)handlers.size(), port);
+}
+
+void ESP8266WebServer::send(int code, const char *contentType, const String &content) {
+  printf("[sim] web server response %d (%u bytes)\n", code, content.length());
+}
+
+String ESP8266WebServer::arg(const String &name) const {
+  std::map<std::string, std::string>::const_iterator it = args.find(name.str());
+  return it == args.end() ? String() : String(it->second);
+}
+
+// Certificate store
+
+int BearSSL::CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *dataFileName) {
+  // Certificates are not validated by the simulated client
+  return fs.exists(indexFileName) && fs.exists(dataFileName) ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#include "SPI.h"
+#include "Hal.h"
+
+SPIClass SPI;
+
+void SPIClass::setDataMode(uint8_t dataMode) {
+  HalSpi::setMode(dataMode);
+}
+
+void SPIClass::setFrequency(uint32_t freq) {
+  HalSpi::setFrequency(freq);
+}
+
+void SPIClass::setClockDivider(uint32_t clockDiv) {
+  // Only the divider values used with the 80 MHz APB clock are meaningful
+  if (clockDiv > 0) HalSpi::setFrequency(80000000 / clockDiv);
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  HalSpi::setFrequency(settings._clock);
+  HalSpi::setMode(settings._dataMode);
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  return HalSpi::transfer(data);
+}
+
+uint16_t SPIClass::transfer16(uint16_t data) {
+  uint16_t hi = HalSpi::transfer(data >> 8);
+  return (hi << 8) | HalSpi::transfer(data & 0xFF);
+}
+
+void SPIClass::transfer(void *buf, uint16_t count) {
+  uint8_t *p = (uint8_t *)buf;
+  while (count--) {
+    *p = HalSpi::transfer(*p);
+    p++;
+  }
+}
+
+void SPIClass::write(uint8_t data) {
+  HalSpi::transfer(data);
+}
+
+void SPIClass::write16(uint16_t data) {
+  write16(data, true);
+}
+
+void SPIClass::write16(uint16_t data, bool msb) {
+  if (msb) {
+    HalSpi::transfer(data >> 8);
+    HalSpi::transfer(data & 0xFF);
+  } else {
+    HalSpi::transfer(data & 0xFF);
+    HalSpi::transfer(data >> 8);
+  }
+}
+
+void SPIClass::write32(uint32_t data) {
+  write32(data, true);
+}
+
+void SPIClass::write32(uint32_t data, bool msb) {
+  if (msb) {
+    write16(data >> 16, true);
+    write16(data & 0xFFFF, true);
+  } else {
+    write16(data & 0xFFFF, false);
+    write16(data >> 16, false);
+  }
+}
+
+void SPIClass::writeBytes(const uint8_t *data, uint32_t size) {
+  while (size--) {
+    HalSpi::transfer(*data++);
+  }
+}
+
+void SPIClass::writePattern(const uint8_t *data, uint8_t size, uint32_t repeat) {
+  // As in the ESP8266 core, patterns must fit the 64 byte FIFO
+  if (size > 64) return;
+  while (repeat--) {
+    for (uint8_t i = 0; i < size; i++) {
+      HalSpi::transfer(data[i]);
+    }
+  }
+}
+
+void SPIClass::transferBytes(const uint8_t *out, uint8_t *in, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++) {
+    uint8_t b = HalSpi::transfer(out ? out[i] : 0xFF);
+    if (in) in[i] = b;
+  }
+}
@@ -0,0 +1,51 @@
+// ESP8266 SPIClass on the simulated bus
+
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include <Arduino.h>
+
+#define SPI_HAS_TRANSACTION 1
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x10
+#define SPI_MODE3 0x11
+
+class SPISettings {
+public:
+  SPISettings() : _clock(1000000), _bitOrder(MSBFIRST), _dataMode(SPI_MODE0) {}
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+    : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+  uint32_t _clock;
+  uint8_t _bitOrder;
+  uint8_t _dataMode;
+};
+
+class SPIClass {
+public:
+  bool begin() { return true; }
+  void end() {}
+  void setHwCs(bool use) {}
+  void setBitOrder(uint8_t bitOrder) {}
+  void setDataMode(uint8_t dataMode);
+  void setFrequency(uint32_t freq);
+  void setClockDivider(uint32_t clockDiv);
+  void beginTransaction(SPISettings settings);
+  void endTransaction(void) {}
+  uint8_t transfer(uint8_t data);
+  uint16_t transfer16(uint16_t data);
+  void transfer(void *buf, uint16_t count);
+  void write(uint8_t data);
+  void write16(uint16_t data);
+  void write16(uint16_t data, bool msb);
+  void write32(uint32_t data);
+  void write32(uint32_t data, bool msb);
+  void writeBytes(const uint8_t *data, uint32_t size);
+  void writePattern(const uint8_t *data, uint8_t size, uint32_t repeat);
+  void transferBytes(const uint8_t *out, uint8_t *in, uint32_t size);
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,208 @@
+#include <stdio.h>
+
+#include "SimIli9341.h"
+
+#define CMD_NOP 0x00
+#define CMD_SWRESET 0x01
+#define CMD_CASET 0x2A
+#define CMD_PASET 0x2B
+#define CMD_RAMWR 0x2C
+#define CMD_VSCRDEF 0x33
+#define CMD_MADCTL 0x36
+#define CMD_VSCRSADD 0x37
+
+#define MADCTL_MY 0x80
+#define MADCTL_MX 0x40
+#define MADCTL_MV 0x20
+
+SimIli9341::SimIli9341(uint8_t dcPin)
+  : dcPin(dcPin), gram(new uint16_t[SIM_ILI9341_WIDTH * SIM_ILI9341_HEIGHT]()),
+    cmd(CMD_NOP), nArgs(0), madctl(0), x0(0), x1(SIM_ILI9341_WIDTH - 1), y0(0),
+    y1(SIM_ILI9341_HEIGHT - 1), col(0), row(0), tfa(0), vsa(SIM_ILI9341_HEIGHT), vsp(0),
+    pixelHi(0), havePixelHi(false),
+    frameBytes(0), frameTransactions(0), frameWindows(0), framePixels(0), stats() {}
+
+// Logical window coordinates to frame memory, following MADCTL the way
+// the controller does: MV exchanges rows and columns, MX and MY mirror them
+
+uint32_t SimIli9341::address(uint16_t c, uint16_t r) const {
+  uint16_t pc = madctl & MADCTL_MV ? r : c;
+  uint16_t pr = madctl & MADCTL_MV ? c : r;
+  if (pc >= SIM_ILI9341_WIDTH || pr >= SIM_ILI9341_HEIGHT) return UINT32_MAX;
+  if (madctl & MADCTL_MX) pc = SIM_ILI9341_WIDTH - 1 - pc;
+  if (madctl & MADCTL_MY) pr = SIM_ILI9341_HEIGHT - 1 - pr;
+  return (uint32_t)pr * SIM_ILI9341_WIDTH + pc;
+}
+
+int16_t SimIli9341::width() const {
+  return madctl & MADCTL_MV ? SIM_ILI9341_HEIGHT : SIM_ILI9341_WIDTH;
+}
+
+int16_t SimIli9341::height() const {
+  return madctl & MADCTL_MV ? SIM_ILI9341_WIDTH : SIM_ILI9341_HEIGHT;
+}
+
+// Frame memory line shown on a given display line. Lines in the scrolling
+// area show memory starting at line vsp, wrapping within the area.
+
+uint16_t SimIli9341::scrolled(uint16_t line) const {
+  if (line < tfa || line >= tfa + vsa || vsp < tfa || vsp >= tfa + vsa) return line;
+  return tfa + (line - tfa + vsp - tfa) % vsa;
+}
+
+uint16_t SimIli9341::pixel(int16_t x, int16_t y) const {
+  if (x < 0 || y < 0) return 0;
+  uint32_t a = address(x, y);
+  if (a == UINT32_MAX) return 0;
+  return gram[scrolled(a / SIM_ILI9341_WIDTH) * SIM_ILI9341_WIDTH + a % SIM_ILI9341_WIDTH];
+}
+
+// Binary PPM, in the orientation the firmware is currently drawing in
+
+bool SimIli9341::screenshot(const char *path) const {
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %d\n255\n", width(), height());
+  for (int16_t y = 0; y < height(); y++) {
+    for (int16_t x = 0; x < width(); x++) {
+      uint16_t c = pixel(x, y);
+      uint8_t rgb[3] = {
+        (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+        (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+        (uint8_t)((c & 0x1F) * 255 / 31)
+      };
+      fwrite(rgb, 1, sizeof(rgb), f);
+    }
+  }
+  return fclose(f) == 0;
+}
+
+// FNV-1a over the frame memory, for comparing screens between runs
+
+uint32_t SimIli9341::checksum() const {
+  uint32_t h = 2166136261u;
+  for (int16_t y = 0; y < height(); y++) {
+    for (int16_t x = 0; x < width(); x++) {
+      uint16_t c = pixel(x, y);
+      h = (h ^ (c >> 8)) * 16777619u;
+      h = (h ^ (c & 0xFF)) * 16777619u;
+    }
+  }
+  return h;
+}
+
+void SimIli9341::beginFrame() {
+  frameBytes = frameTransactions = frameWindows = framePixels = 0;
+}
+
+void SimIli9341::endFrame() {
+  if (!frameBytes) return;
+  stats.frames++;
+  stats.bytes += frameBytes;
+  stats.transactions += frameTransactions;
+  stats.windows += frameWindows;
+  stats.pixels += framePixels;
+  if (frameBytes > stats.maxBytes) stats.maxBytes = frameBytes;
+  if (frameTransactions > stats.maxTransactions) stats.maxTransactions = frameTransactions;
+}
+
+void SimIli9341::report() const {
+  printf("Display: %u frames", stats.frames);
+  if (stats.frames) {
+    printf(", per frame %.0f bytes (max %u), %.0f transactions (max %u), %.0f address windows, %.0f pixels",
+           (double)stats.bytes / stats.frames, stats.maxBytes,
+           (double)stats.transactions / stats.frames, stats.maxTransactions,
+           (double)stats.windows / stats.frames, (double)stats.pixels / stats.frames);
+  }
+  printf("\n  framebuffer checksum %08x\n", checksum());
+}
+
+void SimIli9341::select() {
+  frameTransactions++;
+}
+
+uint8_t SimIli9341::transfer(uint8_t out) {
+  frameBytes++;
+  if (HalGpio::read(dcPin)) {
+    data(out);
+  } else {
+    command(out);
+  }
+  return 0;
+}
+
+void SimIli9341::command(uint8_t c) {
+  cmd = c;
+  nArgs = 0;
+  havePixelHi = false;
+  switch (c) {
+    case CMD_SWRESET:
+      madctl = 0;
+      tfa = 0;
+      vsa = SIM_ILI9341_HEIGHT;
+      vsp = 0;
+      break;
+    case CMD_CASET:
+    case CMD_PASET:
+      frameWindows++;
+      break;
+    case CMD_RAMWR:
+      col = x0;
+      row = y0;
+      break;
+  }
+}
+
+void SimIli9341::data(uint8_t value) {
+  switch (cmd) {
+    case CMD_CASET:
+    case CMD_PASET:
+      if (nArgs < 4) args[nArgs++] = value;
+      if (nArgs == 4) {
+        uint16_t start = args[0] << 8 | args[1];
+        uint16_t end = args[2] << 8 | args[3];
+        if (cmd == CMD_CASET) {
+          x0 = start;
+          x1 = end;
+        } else {
+          y0 = start;
+          y1 = end;
+        }
+      }
+      break;
+    case CMD_MADCTL:
+      madctl = value;
+      break;
+    case CMD_VSCRDEF:
+      // The bottom area is implied by the other two
+      if (nArgs < 4) args[nArgs++] = value;
+      if (nArgs == 4) {
+        tfa = args[0] << 8 | args[1];
+        vsa = args[2] << 8 | args[3];
+      }
+      break;
+    case CMD_VSCRSADD:
+      if (nArgs < 2) args[nArgs++] = value;
+      if (nArgs == 2) vsp = args[0] << 8 | args[1];
+      break;
+    case CMD_RAMWR:
+      if (!havePixelHi) {
+        pixelHi = value;
+        havePixelHi = true;
+      } else {
+        havePixelHi = false;
+        writePixel(pixelHi << 8 | value);
+      }
+      break;
+  }
+}
+
+void SimIli9341::writePixel(uint16_t color) {
+  framePixels++;
+  uint32_t a = address(col, row);
+  if (a != UINT32_MAX) gram[a] = color;
+  if (col++ >= x1) {
+    col = x0;
+    if (row++ >= y1) row = y0;
+  }
+}
@@ -0,0 +1,67 @@
+// Model of the ILI9341 display controller. Decodes the command stream sent
+// over SPI (the D/C pin selects command or data), keeps the 240x320 RGB565
+// frame memory and accounts bus traffic per frame, where a frame is
+// whatever the firmware sends between beginFrame() and endFrame().
+
+#ifndef _SIM_ILI9341_H_
+#define _SIM_ILI9341_H_
+
+#include "Hal.h"
+
+#define SIM_ILI9341_WIDTH 240
+#define SIM_ILI9341_HEIGHT 320
+
+struct SimFrameStats {
+  uint32_t frames;
+  uint64_t bytes;
+  uint64_t transactions;
+  uint64_t windows;
+  uint64_t pixels;
+  uint32_t maxBytes;
+  uint32_t maxTransactions;
+};
+
+class SimIli9341 : public SpiDevice {
+public:
+  explicit SimIli9341(uint8_t dcPin);
+  uint16_t pixel(int16_t x, int16_t y) const;
+  int16_t width() const;
+  int16_t height() const;
+  bool screenshot(const char *path) const;
+  uint32_t checksum() const;
+
+  void beginFrame();
+  void endFrame();
+  const SimFrameStats &frameStats() const { return stats; }
+  void report() const;
+
+  void select() override;
+  uint8_t transfer(uint8_t out) override;
+  // Beyond the datasheet's 10 MHz, but what these panels are driven at
+  uint32_t maxFrequency() const override { return 40000000; }
+  bool acceptsMode(uint8_t mode) const override { return mode == 0x00 || mode == 0x11; }
+
+private:
+  void command(uint8_t cmd);
+  void data(uint8_t value);
+  void writePixel(uint16_t color);
+  uint32_t address(uint16_t col, uint16_t row) const;
+  uint16_t scrolled(uint16_t line) const;
+
+  uint8_t dcPin;
+  uint16_t *gram;
+  uint8_t cmd;
+  uint8_t args[4];
+  uint8_t nArgs;
+  uint8_t madctl;
+  uint16_t x0, x1, y0, y1;
+  uint16_t col, row;
+  uint16_t tfa, vsa, vsp;
+  uint8_t pixelHi;
+  bool havePixelHi;
+
+  uint32_t frameBytes, frameTransactions, frameWindows, framePixels;
+  SimFrameStats stats;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+#include "SimKettle.h"
+
+// Water: specific heat in J/(kg K) and latent heat of evaporation in J/kg
+
+#define WATER_HEAT 4186.0
+#define WATER_LATENT 2.257e6
+
+SimKettle::SimKettle()
+  : active(false), water(20), probe(20), startTemp(20), massKg(0), boiledKg(0), lastNs(0),
+    heaterOn(false), delayedOn(false), hasTarget(false), target(0), firstOnNs(0),
+    started(false), rise10Ns(0), rise90Ns(0), settledNs(0), peak(20), energyWs(0) {}
+
+void SimKettle::begin(const SimKettleParams &params, double startC) {
+  this->params = params;
+  active = true;
+  water = probe = startTemp = peak = startC;
+  massKg = params.litres;
+}
+
+// Switch the element at nowNs. The water feels it deadTimeS later.
+
+void SimKettle::setHeater(bool on, uint64_t nowNs) {
+  advance(nowNs);
+  if (on == heaterOn) return;
+  heaterOn = on;
+  edges.push_back(std::make_pair(nowNs + (uint64_t)(params.deadTimeS * 1e9), on));
+  if (on && !started) {
+    started = true;
+    firstOnNs = nowNs;
+  }
+}
+
+// Bring the model up to nowNs in steps of at most SIM_KETTLE_STEP_NS, taking
+// delayed heater edges at their exact times
+
+void SimKettle::advance(uint64_t nowNs) {
+  if (!active) return;
+  while (lastNs < nowNs) {
+    uint64_t until = std::min<uint64_t>(nowNs, lastNs + SIM_KETTLE_STEP_NS);
+    if (!edges.empty() && edges.front().first < until) until = std::max<uint64_t>(edges.front().first, lastNs);
+    step((until - lastNs) / 1e9, delayedOn);
+    lastNs = until;
+    while (!edges.empty() && edges.front().first <= lastNs) {
+      delayedOn = edges.front().second;
+      edges.pop_front();
+    }
+    track(lastNs);
+  }
+}
+
+void SimKettle::step(double dtS, bool heating) {
+  double power = heating ? params.heaterWatts : 0;
+  if (heating) energyWs += params.heaterWatts * dtS;
+  double net = power - params.lossWattsPerK * (water - params.ambientC);
+  double heatCapacity = massKg * WATER_HEAT;
+  water += net * dtS / heatCapacity;
+  if (water > SIM_KETTLE_BOIL_C) {
+    double surplus = (water - SIM_KETTLE_BOIL_C) * heatCapacity;
+    double evaporated = std::min(surplus / WATER_LATENT, massKg * 0.5);
+    massKg -= evaporated;
+    boiledKg += evaporated;
+    water = SIM_KETTLE_BOIL_C;
+  }
+  if (params.probeLagS > 0) {
+    probe += (water - probe) * (1 - exp(-dtS / params.probeLagS));
+  } else {
+    probe = water;
+  }
+}
+
+// Step response figures for the water, once there is a target and the
+// heater has been on
+
+void SimKettle::setTarget(double celsius) {
+  hasTarget = true;
+  target = celsius;
+}
+
+void SimKettle::track(uint64_t nowNs) {
+  if (!hasTarget || !started) return;
+  double span = target - startTemp;
+  double progress = span ? (water - startTemp) / span : 1;
+  if (!rise10Ns && progress >= 0.1) rise10Ns = nowNs;
+  if (!rise90Ns && progress >= 0.9) rise90Ns = nowNs;
+  if (water > peak) peak = water;
+  if (fabs(water - target) > SIM_KETTLE_SETTLE_BAND) {
+    settledNs = 0;
+  } else if (!settledNs) {
+    settledNs = nowNs;
+  }
+}
+
+void SimKettle::report() const {
+  if (!active) return;
+  printf("Kettle: %.1f l, %.0f W, water %.2f C, probe %.2f C, %.3f kWh used, %.2f l boiled off\n",
+         params.litres, params.heaterWatts, water, probe, energyWs / 3.6e6, boiledKg);
+  if (!hasTarget) return;
+  printf("  step to %.1f C:", target);
+  if (!started) {
+    printf(" heater never on\n");
+    return;
+  }
+  if (rise90Ns) {
+    printf(" rise time %.1f s,", (rise90Ns - rise10Ns) / 1e9);
+  } else {
+    printf(" rise time -,");
+  }
+  printf(" overshoot %.2f C,", std::max(peak - target, 0.0));
+  if (settledNs) {
+    printf(" settling time %.1f s\n", (settledNs - firstOnNs) / 1e9);
+  } else {
+    printf(" settling time -\n");
+  }
+}
@@ -0,0 +1,66 @@
+// Thermal model of a kettle of water heated by the element behind the SSR,
+// for running the controller in closed loop. The water is a single lumped
+// mass losing heat to the room in proportion to the temperature difference,
+// through the lid and walls. Heat reaches the water after a dead time, and
+// the probe follows the water through a first-order lag. At the boiling
+// point the surplus power evaporates water instead of heating it.
+//
+// The model also records the step response of the water temperature
+// towards a target: rise time (10-90%), overshoot and settling time into a
+// band around the target, all timed from the first time the heater came on.
+
+#ifndef _SIM_KETTLE_H_
+#define _SIM_KETTLE_H_
+
+#include <deque>
+#include <stdint.h>
+
+#define SIM_KETTLE_STEP_NS 10000000
+#define SIM_KETTLE_BOIL_C 100.0
+#define SIM_KETTLE_SETTLE_BAND 0.5
+
+struct SimKettleParams {
+  double litres;
+  double heaterWatts;
+  double lossWattsPerK;  // to the room, through lid and walls
+  double probeLagS;      // time constant of the probe
+  double deadTimeS;      // from element to water at the probe
+  double ambientC;
+};
+
+class SimKettle {
+public:
+  SimKettle();
+  void begin(const SimKettleParams &params, double startC);
+  bool enabled() const { return active; }
+  void setHeater(bool on, uint64_t nowNs);
+  void advance(uint64_t nowNs);
+  double waterTemperature() const { return water; }
+  double probeTemperature() const { return probe; }
+  void setTarget(double celsius);
+  void report() const;
+
+private:
+  void step(double dtS, bool heating);
+  void track(uint64_t nowNs);
+
+  SimKettleParams params;
+  bool active;
+  double water, probe, startTemp, massKg, boiledKg;
+  uint64_t lastNs;
+  bool heaterOn;
+  std::deque<std::pair<uint64_t, bool> > edges;  // heater edges inside the dead time
+  bool delayedOn;
+
+  // Step response
+
+  bool hasTarget;
+  double target;
+  uint64_t firstOnNs;
+  bool started;
+  uint64_t rise10Ns, rise90Ns, settledNs;
+  double peak;
+  double energyWs;
+};
+
+#endif
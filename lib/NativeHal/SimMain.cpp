@@ -0,0 +1,401 @@
+// Entry point for the native build. Wires the simulated peripherals to the
+// pins used by the controller board, then runs the firmware's setup() and
+// loop() until the requested amount of simulated time has passed. Unit
+// tests under test/ bring their own main() and skip this file.
+
+#ifndef PIO_UNIT_TESTING
+
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <vector>
+
+#include <Arduino.h>
+#include "Hal.h"
+#include "SimIli9341.h"
+#include "SimKettle.h"
+#include "SimMax31865.h"
+#include "SimXpt2046.h"
+
+// Board wiring, as in src/main.cpp
+
+#define SIM_TFT_CS 15
+#define SIM_TFT_DC 2
+#define SIM_TOUCH_CS 4
+#define SIM_TOUCH_IRQ 5
+#define SIM_RTD_CS 16
+#define SIM_SSR_PIN 5
+
+// SSR cycle, as SSR_CYCLE_TIME in src/main.cpp
+
+#define SIM_SSR_CYCLE_MS 5000
+
+// RTD probe and reference resistor fitted to the board
+
+#define SIM_RNOMINAL 100.0
+#define SIM_RREF 430.0
+
+// Kettle defaults for --kettle: lidded pot, probe in a thermowell, and the
+// room temperature
+
+#define SIM_KETTLE_LOSS 8.0
+#define SIM_KETTLE_LAG 5.0
+#define SIM_KETTLE_DEAD_TIME 10.0
+#define SIM_AMBIENT 20.0
+
+// Touch panel calibration passed to touch.setCalibration() and the margin
+// used by the XPT2046 library, so screen positions can be turned back into
+// raw ADC readings
+
+#define SIM_TOUCH_CAL_X1 1816
+#define SIM_TOUCH_CAL_Y1 281
+#define SIM_TOUCH_CAL_X2 262
+#define SIM_TOUCH_CAL_Y2 1768
+#define SIM_TOUCH_MARGIN 20
+#define SIM_TOUCH_WIDTH 240
+#define SIM_TOUCH_HEIGHT 320
+
+void setup();
+void loop();
+
+struct TouchEvent {
+  uint32_t atMs;
+  uint32_t durationMs;
+  uint16_t x, y;
+};
+
+// Where one kind of SSR edge falls within the SSR cycle, relative to the
+// first such edge. The spread between earliest and latest is the jitter.
+
+struct EdgeJitter {
+  bool seen;
+  uint64_t firstNs;
+  int64_t minNs, maxNs;
+};
+
+struct Screenshot {
+  uint64_t atNs;
+  std::string path;
+  bool taken;
+};
+
+static SimMax31865 rtd(SIM_RNOMINAL, SIM_RREF);
+static SimXpt2046 touchPanel(SIM_TOUCH_IRQ);
+static SimIli9341 panel(SIM_TFT_DC);
+static SimKettle kettle;
+static std::vector<TouchEvent> touches;
+static std::vector<Screenshot> screenshots;
+static uint64_t loops = 0;
+static uint64_t setupNs = 0;
+static uint64_t ssrOnNs = 0;
+static uint64_t ssrOnSince = 0;
+static bool ssrOn = false;
+static EdgeJitter ssrRising, ssrFalling;
+static bool strict = false;
+
+static void usage(const char *argv0) {
+  printf("Usage: %s [options]\n"
+         "  --fs DIR              host directory used as LittleFS (default data)\n"
+         "  --duration SEC        simulated seconds to run, 0 = forever (default 60, realtime 0)\n"
+         "  --realtime            follow the host clock instead of virtual time\n"
+         "  --loop-us US          simulated CPU time per loop() pass (default 250)\n"
+         "  --pot VALUE           potentiometer reading on A0, 0-1023 (default 512)\n"
+         "  --temp C              probe temperature (default 20)\n"
+         "  --rtd-fault BITS      MAX31865 fault status bits to report\n"
+         "  --kettle L:W[:LOSS[:LAG[:DEAD]]] heat L litres of water from --temp with W watts,\n"
+         "                        losing LOSS W/K (default 8), probe lag LAG s (default 5),\n"
+         "                        dead time DEAD s (default 10)\n"
+         "  --target C            report the kettle's step response towards C\n"
+         "  --touch MS:X:Y[:DUR]  touch landscape screen position X,Y at MS for DUR ms (default 200)\n"
+         "  --input PATH=JSON[@SEC] stream PATH under <board>/inputs at SEC (default 0)\n"
+         "  --screenshot FILE[@SEC] save the screen as PPM at SEC (default at exit)\n"
+         "  --http URL=CODE:BODY  response for an HTTPS GET of URL\n"
+         "  --rtdb-cost MS:MS     simulated cost of async and sync RTDB requests (default 20:150)\n"
+         "  --no-wifi             the configured access point is out of range\n"
+         "  --quiet               suppress serial output\n"
+         "  --strict              exit with status 2 on any SPI bus violation\n",
+         argv0);
+}
+
+// Invert the XPT2046 library's calibration, taking a position in the
+// landscape orientation used by the firmware's screens
+
+static void touchToRaw(uint16_t x, uint16_t y, uint16_t &adcX, uint16_t &adcY) {
+  long px = SIM_TOUCH_WIDTH - y;
+  long py = x;
+  long vi = SIM_TOUCH_CAL_X1 + (px - SIM_TOUCH_MARGIN) * (SIM_TOUCH_CAL_X2 - SIM_TOUCH_CAL_X1) /
+            (SIM_TOUCH_WIDTH - 2 * SIM_TOUCH_MARGIN);
+  long vj = SIM_TOUCH_CAL_Y1 + (py - SIM_TOUCH_MARGIN) * (SIM_TOUCH_CAL_Y2 - SIM_TOUCH_CAL_Y1) /
+            (SIM_TOUCH_HEIGHT - 2 * SIM_TOUCH_MARGIN);
+  adcX = constrain(vi * 2, 0, 4095);
+  adcY = constrain(vj * 2, 0, 4095);
+}
+
+static void updateTouch(uint32_t ms) {
+  bool touching = false;
+  for (size_t i = 0; i < touches.size(); i++) {
+    const TouchEvent &t = touches[i];
+    if (ms >= t.atMs && ms < t.atMs + t.durationMs) {
+      uint16_t adcX, adcY;
+      touchToRaw(t.x, t.y, adcX, adcY);
+      touchPanel.press(adcX, adcY);
+      touching = true;
+      break;
+    }
+  }
+  if (!touching && touchPanel.pressed()) touchPanel.release();
+}
+
+static void takeScreenshots(bool exiting) {
+  for (size_t i = 0; i < screenshots.size(); i++) {
+    Screenshot &s = screenshots[i];
+    if (s.taken || (!exiting && HalClock::peekNanos() < s.atNs)) continue;
+    s.taken = true;
+    if (!panel.screenshot(s.path.c_str())) {
+      fprintf(stderr, "Unable to write %s\n", s.path.c_str());
+    }
+  }
+}
+
+// Bring the kettle up to the current time and show the probe to the RTD
+// converter
+
+static void updateKettle() {
+  if (!kettle.enabled()) return;
+  kettle.advance(HalClock::peekNanos());
+  rtd.setTemperature(kettle.probeTemperature());
+}
+
+// Keep touches, screenshots and the kettle going while the firmware blocks
+// in delay()
+
+static void onSleep() {
+  updateTouch(HalClock::peekNanos() / 1000000);
+  updateKettle();
+  takeScreenshots(false);
+}
+
+static void recordEdge(EdgeJitter &j, uint64_t now) {
+  if (!j.seen) {
+    j.seen = true;
+    j.firstNs = now;
+    return;
+  }
+  const int64_t cycleNs = SIM_SSR_CYCLE_MS * 1000000LL;
+  int64_t phase = (int64_t)((now - j.firstNs) % cycleNs);
+  if (phase > cycleNs / 2) phase -= cycleNs;
+  if (phase < j.minNs) j.minNs = phase;
+  if (phase > j.maxNs) j.maxNs = phase;
+}
+
+static void onSsr(uint8_t pin, uint8_t level, void *ctx) {
+  uint64_t now = HalClock::peekNanos();
+  if (level && !ssrOn) {
+    ssrOnSince = now;
+    recordEdge(ssrRising, now);
+  }
+  if (!level && ssrOn) {
+    ssrOnNs += now - ssrOnSince;
+    recordEdge(ssrFalling, now);
+  }
+  ssrOn = level;
+  if (kettle.enabled()) kettle.setHeater(level, now);
+}
+
+static void report() {
+  uint64_t now = HalClock::peekNanos();
+  if (ssrOn) ssrOnNs += now - ssrOnSince, ssrOnSince = now;
+  takeScreenshots(true);
+  fflush(stdout);
+  printf("\n--- Simulation summary ---\n");
+  printf("Simulated time %.3f s (setup %.3f s), %llu loop passes", now / 1e9, setupNs / 1e9,
+         (unsigned long long)loops);
+  if (loops) printf(" (%.1f us/pass)", (now - setupNs) / 1e3 / loops);
+  printf("\n");
+  HalSpi::report();
+  panel.report();
+  HalNet::report();
+  printf("SSR: %u edges, on %.1f%% of the time\n", HalGpio::edges(SIM_SSR_PIN),
+         now ? 100.0 * ssrOnNs / now : 0.0);
+  printf("  edge jitter within the cycle: rising %.1f ms, falling %.1f ms\n",
+         (ssrRising.maxNs - ssrRising.minNs) / 1e6, (ssrFalling.maxNs - ssrFalling.minNs) / 1e6);
+  printf("Timer1: %u interrupts, max latency %.1f us\n", HalTimer::fired(),
+         HalTimer::maxLatencyNs() / 1e3);
+  printf("RTD: %u conversions\n", rtd.conversions());
+  kettle.report();
+  if (strict && HalSpi::violations()) {
+    printf("FAILED: %u SPI bus violations\n", HalSpi::violations());
+    fflush(stdout);
+    _exit(2);
+  }
+}
+
+static void onSignal(int sig) {
+  exit(0);
+}
+
+int main(int argc, char **argv) {
+  static const struct option options[] = {
+    { "fs", required_argument, NULL, 'f' },
+    { "duration", required_argument, NULL, 'd' },
+    { "realtime", no_argument, NULL, 'r' },
+    { "loop-us", required_argument, NULL, 'l' },
+    { "pot", required_argument, NULL, 'p' },
+    { "temp", required_argument, NULL, 't' },
+    { "rtd-fault", required_argument, NULL, 'F' },
+    { "kettle", required_argument, NULL, 'k' },
+    { "target", required_argument, NULL, 'g' },
+    { "touch", required_argument, NULL, 'T' },
+    { "input", required_argument, NULL, 'i' },
+    { "screenshot", required_argument, NULL, 's' },
+    { "http", required_argument, NULL, 'H' },
+    { "rtdb-cost", required_argument, NULL, 'c' },
+    { "no-wifi", no_argument, NULL, 'w' },
+    { "quiet", no_argument, NULL, 'q' },
+    { "strict", no_argument, NULL, 'S' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+
+  double duration = -1;
+  bool realtime = false;
+  uint32_t loopUs = 250;
+  int pot = 512;
+  SimKettleParams kettleParams = { 0, 0, SIM_KETTLE_LOSS, SIM_KETTLE_LAG, SIM_KETTLE_DEAD_TIME,
+                                   SIM_AMBIENT };
+  int opt;
+  while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (opt) {
+      case 'f':
+        HalFs::setRoot(optarg);
+        break;
+      case 'd':
+        duration = atof(optarg);
+        break;
+      case 'r':
+        realtime = true;
+        break;
+      case 'l':
+        loopUs = strtoul(optarg, NULL, 10);
+        break;
+      case 'p':
+        pot = atoi(optarg);
+        break;
+      case 't':
+        rtd.setTemperature(atof(optarg));
+        break;
+      case 'F':
+        rtd.setFault(strtoul(optarg, NULL, 0));
+        break;
+      case 'k':
+        if (sscanf(optarg, "%lf:%lf:%lf:%lf:%lf", &kettleParams.litres,
+                   &kettleParams.heaterWatts, &kettleParams.lossWattsPerK,
+                   &kettleParams.probeLagS, &kettleParams.deadTimeS) < 2 ||
+            kettleParams.litres <= 0) {
+          fprintf(stderr, "Bad --kettle %s\n", optarg);
+          return 1;
+        }
+        break;
+      case 'g':
+        kettle.setTarget(atof(optarg));
+        break;
+      case 'T': {
+        unsigned ms, x, y, dur = 200;
+        if (sscanf(optarg, "%u:%u:%u:%u", &ms, &x, &y, &dur) < 3) {
+          fprintf(stderr, "Bad --touch %s\n", optarg);
+          return 1;
+        }
+        touches.push_back({ ms, dur, (uint16_t)x, (uint16_t)y });
+        break;
+      }
+      case 'i': {
+        std::string arg = optarg;
+        size_t eq = arg.find('=');
+        size_t at = arg.rfind('@');
+        if (eq == std::string::npos) {
+          fprintf(stderr, "Bad --input %s\n", optarg);
+          return 1;
+        }
+        if (at == std::string::npos || at < eq) at = arg.size();
+        uint32_t atMs = at < arg.size() ? (uint32_t)(atof(arg.c_str() + at + 1) * 1000) : 0;
+        HalNet::queueInput(atMs, arg.substr(0, eq), arg.substr(eq + 1, at - eq - 1));
+        break;
+      }
+      case 's': {
+        std::string arg = optarg;
+        size_t at = arg.rfind('@');
+        uint64_t atNs = UINT64_MAX;
+        if (at != std::string::npos) {
+          atNs = (uint64_t)(atof(arg.c_str() + at + 1) * 1e9);
+          arg.erase(at);
+        }
+        screenshots.push_back({ atNs, arg, false });
+        break;
+      }
+      case 'H': {
+        std::string arg = optarg;
+        size_t eq = arg.find('=');
+        size_t colon = arg.find(':', eq);
+        if (eq == std::string::npos || colon == std::string::npos) {
+          fprintf(stderr, "Bad --http %s\n", optarg);
+          return 1;
+        }
+        HalNet::setHttpResponse(arg.substr(0, eq).c_str(), atoi(arg.c_str() + eq + 1),
+                                arg.c_str() + colon + 1);
+        break;
+      }
+      case 'c': {
+        unsigned asyncMs, syncMs;
+        if (sscanf(optarg, "%u:%u", &asyncMs, &syncMs) != 2) {
+          fprintf(stderr, "Bad --rtdb-cost %s\n", optarg);
+          return 1;
+        }
+        HalNet::setRequestCost(asyncMs, syncMs);
+        break;
+      }
+      case 'w':
+        HalNet::setWifiAvailable(false);
+        break;
+      case 'q':
+        Serial.setQuiet(true);
+        break;
+      case 'S':
+        strict = true;
+        break;
+      default:
+        usage(argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (duration < 0) duration = realtime ? 0 : 60;
+
+  HalClock::setRealtime(realtime);
+  HalAdc::set(A0, pot);
+  if (kettleParams.litres > 0) kettle.begin(kettleParams, rtd.temperature());
+  HalSpi::attach(SIM_TFT_CS, &panel, "ILI9341");
+  HalSpi::attach(SIM_TOUCH_CS, &touchPanel, "XPT2046");
+  HalSpi::attach(SIM_RTD_CS, &rtd, "MAX31865");
+  HalGpio::addListener(SIM_SSR_PIN, onSsr, NULL);
+  HalClock::setSleepHook(onSleep);
+
+  atexit(report);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  uint64_t endNs = (uint64_t)(duration * 1e9);
+  setup();
+  setupNs = HalClock::peekNanos();
+  while (!endNs || HalClock::peekNanos() < endNs) {
+    updateTouch(millis());
+    updateKettle();
+    panel.beginFrame();
+    loop();
+    panel.endFrame();
+    loops++;
+    takeScreenshots(false);
+    HalClock::advance((uint64_t)loopUs * 1000);
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include <math.h>
+
+#include "SimMax31865.h"
+
+// Callendar-Van Dusen coefficients (IEC 60751)
+#define CVD_A 3.9083e-3
+#define CVD_B -5.775e-7
+#define CVD_C -4.183e-12
+
+#define REG_CONFIG 0x00
+#define REG_RTD_MSB 0x01
+#define REG_RTD_LSB 0x02
+#define REG_HFAULT_MSB 0x03
+#define REG_LFAULT_LSB 0x06
+#define REG_FAULT 0x07
+
+#define CONFIG_BIAS 0x80
+#define CONFIG_AUTO 0x40
+#define CONFIG_1SHOT 0x20
+#define CONFIG_FAULT_CLEAR 0x02
+
+#define FAULT_HIGH 0x80
+#define FAULT_LOW 0x40
+
+SimMax31865::SimMax31865(float rNominal, float rRef)
+  : rNominal(rNominal), rRef(rRef), temp(20), addr(0), first(true), writing(false),
+    injectedFault(0), nConversions(0) {
+  for (int i = 0; i < 8; i++) regs[i] = 0;
+  regs[REG_HFAULT_MSB] = 0xFF;
+  regs[REG_HFAULT_MSB + 1] = 0xFF;
+}
+
+void SimMax31865::select() {
+  first = true;
+}
+
+uint8_t SimMax31865::transfer(uint8_t out) {
+  if (first) {
+    first = false;
+    writing = out & 0x80;
+    addr = out & 0x07;
+    return 0xFF;
+  }
+  uint8_t in = 0xFF;
+  if (writing) {
+    writeRegister(addr, out);
+  } else {
+    if (addr == REG_RTD_MSB && (regs[REG_CONFIG] & (CONFIG_AUTO | CONFIG_BIAS)) == (CONFIG_AUTO | CONFIG_BIAS)) {
+      convert();
+    }
+    in = regs[addr];
+  }
+  addr = (addr + 1) & 0x07;
+  return in;
+}
+
+void SimMax31865::writeRegister(uint8_t reg, uint8_t value) {
+  if (reg == REG_CONFIG) {
+    if (value & CONFIG_FAULT_CLEAR) regs[REG_FAULT] = 0;
+    regs[REG_CONFIG] = value & ~(CONFIG_1SHOT | CONFIG_FAULT_CLEAR);
+    if (value & CONFIG_1SHOT) convert();
+  } else if (reg >= REG_HFAULT_MSB && reg <= REG_LFAULT_LSB) {
+    regs[reg] = value;
+  }
+}
+
+void SimMax31865::convert() {
+  double t = temp;
+  double r = 1 + CVD_A * t + CVD_B * t * t;
+  if (t < 0) r += CVD_C * (t - 100) * t * t * t;
+  r *= rNominal;
+  long code = lround(r / rRef * 32768);
+  if (code < 0) code = 0;
+  if (code > 0x7FFF) code = 0x7FFF;
+  uint8_t fault = injectedFault;
+  uint16_t high = (regs[REG_HFAULT_MSB] << 8 | regs[REG_HFAULT_MSB + 1]) >> 1;
+  uint16_t low = (regs[REG_LFAULT_LSB - 1] << 8 | regs[REG_LFAULT_LSB]) >> 1;
+  if (code >= high) fault |= FAULT_HIGH;
+  if (code < low) fault |= FAULT_LOW;
+  if (injectedFault) code = 0x7FFF;
+  regs[REG_FAULT] |= fault;
+  uint16_t reg = (code << 1) | (regs[REG_FAULT] ? 1 : 0);
+  regs[REG_RTD_MSB] = reg >> 8;
+  regs[REG_RTD_LSB] = reg & 0xFF;
+  nConversions++;
+}
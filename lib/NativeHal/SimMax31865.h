@@ -0,0 +1,34 @@
+// Register-level model of the MAX31865 RTD-to-digital converter with a
+// PT100-style probe attached. Conversions are instantaneous.
+
+#ifndef _SIM_MAX31865_H_
+#define _SIM_MAX31865_H_
+
+#include "Hal.h"
+
+class SimMax31865 : public SpiDevice {
+public:
+  SimMax31865(float rNominal, float rRef);
+  void setTemperature(float celsius) { temp = celsius; }
+  float temperature() const { return temp; }
+  void setFault(uint8_t fault) { injectedFault = fault; }
+  uint16_t conversions() const { return nConversions; }
+
+  void select() override;
+  uint8_t transfer(uint8_t out) override;
+  uint32_t maxFrequency() const override { return 5000000; }
+  bool acceptsMode(uint8_t mode) const override { return mode == 0x01 || mode == 0x11; }
+
+private:
+  void writeRegister(uint8_t reg, uint8_t value);
+  void convert();
+
+  float rNominal, rRef, temp;
+  uint8_t regs[8];
+  uint8_t addr;
+  bool first, writing;
+  uint8_t injectedFault;
+  uint16_t nConversions;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "SimXpt2046.h"
+
+#define CTRL_START 0x80
+#define CHANNEL_X 0x1
+#define CHANNEL_Z1 0x3
+#define CHANNEL_Z2 0x4
+#define CHANNEL_Y 0x5
+
+SimXpt2046::SimXpt2046(uint8_t irqPin)
+  : irqPin(irqPin), touching(false), adcX(0), adcY(0), shift(0), shiftBytes(0) {}
+
+void SimXpt2046::press(uint16_t x, uint16_t y) {
+  adcX = x & 0x0FFF;
+  adcY = y & 0x0FFF;
+  touching = true;
+  HalGpio::drive(irqPin, 0);
+}
+
+void SimXpt2046::release() {
+  touching = false;
+  HalGpio::release(irqPin);
+}
+
+void SimXpt2046::select() {
+  shiftBytes = 0;
+}
+
+// The 12-bit result of a conversion follows the control byte after one busy
+// clock, so it is shifted out as (value >> 5) and (value << 3)
+
+uint8_t SimXpt2046::transfer(uint8_t out) {
+  uint8_t in = 0;
+  if (shiftBytes) {
+    in = shift >> 8;
+    shift <<= 8;
+    shiftBytes--;
+  }
+  if (out & CTRL_START) {
+    uint16_t value = 0;
+    switch ((out >> 4) & 0x7) {
+      case CHANNEL_X: value = touching ? adcX : 0; break;
+      case CHANNEL_Y: value = touching ? adcY : 0; break;
+      case CHANNEL_Z1: value = touching ? 0x400 : 0; break;
+      case CHANNEL_Z2: value = touching ? 0xC00 : 0x0FFF; break;
+    }
+    shift = value << 3;
+    shiftBytes = 2;
+  }
+  return in;
+}
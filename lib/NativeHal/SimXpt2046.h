@@ -0,0 +1,30 @@
+// Model of the XPT2046 resistive touch controller. press() takes 12-bit ADC
+// readings for the X (control byte 0x9x) and Y (0xDx) channels as named by
+// the XPT2046 library, and pulls PENIRQ low while the panel is touched.
+
+#ifndef _SIM_XPT2046_H_
+#define _SIM_XPT2046_H_
+
+#include "Hal.h"
+
+class SimXpt2046 : public SpiDevice {
+public:
+  explicit SimXpt2046(uint8_t irqPin);
+  void press(uint16_t adcX, uint16_t adcY);
+  void release();
+  bool pressed() const { return touching; }
+
+  void select() override;
+  uint8_t transfer(uint8_t out) override;
+  uint32_t maxFrequency() const override { return 2500000; }
+  bool acceptsMode(uint8_t mode) const override { return mode == 0x00; }
+
+private:
+  uint8_t irqPin;
+  bool touching;
+  uint16_t adcX, adcY;
+  uint16_t shift;
+  uint8_t shiftBytes;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include "Stream.h"
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length && available()) {
+    buffer[n++] = (char)read();
+  }
+  return n;
+}
+
+String Stream::readString() {
+  String ret;
+  while (available()) {
+    ret += (char)read();
+  }
+  return ret;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String ret;
+  while (available()) {
+    int c = read();
+    if (c == terminator) break;
+    ret += (char)c;
+  }
+  return ret;
+}
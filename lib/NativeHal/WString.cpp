@@ -0,0 +1,125 @@
+#include <ctype.h>
+#include <stdio.h>
+
+#include "WString.h"
+
+const String emptyString;
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+  if (base < 2 || base > 36) base = 10;
+  char buf[72];
+  int i = sizeof(buf) - 1;
+  buf[i] = 0;
+  do {
+    int digit = value % base;
+    buf[--i] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+  if (negative) buf[--i] = '-';
+  return std::string(&buf[i]);
+}
+
+static std::string formatFloat(double value, unsigned char decimalPlaces) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  return buf;
+}
+
+String::String(unsigned char value, unsigned char base) : s(formatInteger(value, false, base)) {}
+
+String::String(int value, unsigned char base)
+  : s(base == 10 && value < 0 ? formatInteger(-(long long)value, true, base)
+                              : formatInteger((unsigned int)value, false, base)) {}
+
+String::String(unsigned int value, unsigned char base) : s(formatInteger(value, false, base)) {}
+
+String::String(long value, unsigned char base)
+  : s(base == 10 && value < 0 ? formatInteger(-(long long)value, true, base)
+                              : formatInteger((unsigned long)value, false, base)) {}
+
+String::String(unsigned long value, unsigned char base) : s(formatInteger(value, false, base)) {}
+
+String::String(float value, unsigned char decimalPlaces) : s(formatFloat(value, decimalPlaces)) {}
+
+String::String(double value, unsigned char decimalPlaces) : s(formatFloat(value, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String &rhs) const {
+  if (s.size() != rhs.s.size()) return false;
+  for (size_t i = 0; i < s.size(); i++) {
+    if (tolower((unsigned char)s[i]) != tolower((unsigned char)rhs.s[i])) return false;
+  }
+  return true;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return s.size() >= suffix.s.size() &&
+         s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t pos = s.find(c, from);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int from) const {
+  size_t pos = s.find(str.s, from);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+  size_t pos = s.rfind(c);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+  if (left > right) {
+    unsigned int tmp = left;
+    left = right;
+    right = tmp;
+  }
+  if (left >= s.size()) return String();
+  if (right > s.size()) right = s.size();
+  return String(s.substr(left, right - left));
+}
+
+void String::replace(const String &find, const String &replace) {
+  if (find.s.empty()) return;
+  size_t pos = 0;
+  while ((pos = s.find(find.s, pos)) != std::string::npos) {
+    s.replace(pos, find.s.size(), replace.s);
+    pos += replace.s.size();
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < s.size()) s.erase(index, count);
+}
+
+void String::toLowerCase() {
+  for (size_t i = 0; i < s.size(); i++) s[i] = tolower((unsigned char)s[i]);
+}
+
+void String::toUpperCase() {
+  for (size_t i = 0; i < s.size(); i++) s[i] = toupper((unsigned char)s[i]);
+}
+
+void String::trim() {
+  size_t first = s.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) {
+    s.clear();
+    return;
+  }
+  size_t last = s.find_last_not_of(" \t\r\n");
+  s = s.substr(first, last - first + 1);
+}
+
+String operator+(const String &lhs, const String &rhs) { return String(lhs.str() + rhs.str()); }
+String operator+(const String &lhs, const char *rhs) { return String(lhs.str() + (rhs ? rhs : "")); }
+String operator+(const char *lhs, const String &rhs) { return String((lhs ? lhs : "") + rhs.str()); }
+String operator+(const String &lhs, char rhs) { return String(lhs.str() + rhs); }
+String operator+(const String &lhs, int rhs) { return lhs + String(rhs); }
+String operator+(const String &lhs, unsigned int rhs) { return lhs + String(rhs); }
+String operator+(const String &lhs, long rhs) { return lhs + String(rhs); }
+String operator+(const String &lhs, unsigned long rhs) { return lhs + String(rhs); }
+String operator+(const String &lhs, float rhs) { return lhs + String(rhs); }
+String operator+(const String &lhs, double rhs) { return lhs + String(rhs); }
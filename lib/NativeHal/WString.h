@@ -0,0 +1,91 @@
+// Arduino String on top of std::string
+
+#ifndef String_class_h
+#define String_class_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class __FlashStringHelper;
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper *>(pstr_pointer))
+#define F(string_literal) (FPSTR(PSTR(string_literal)))
+
+class String {
+public:
+  String(const char *cstr = "") : s(cstr ? cstr : "") {}
+  String(const char *cstr, size_t length) : s(cstr, length) {}
+  String(const std::string &str) : s(str) {}
+  String(const __FlashStringHelper *str) : s(reinterpret_cast<const char *>(str)) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+
+  bool reserve(unsigned int size) { s.reserve(size); return true; }
+  unsigned int length() const { return s.size(); }
+  bool isEmpty() const { return s.empty(); }
+  const char *c_str() const { return s.c_str(); }
+  char *begin() { return &s[0]; }
+  char *end() { return &s[0] + s.size(); }
+  const std::string &str() const { return s; }
+
+  String &operator=(const char *cstr) { s = cstr ? cstr : ""; return *this; }
+  String &operator+=(const String &rhs) { s += rhs.s; return *this; }
+  String &operator+=(const char *cstr) { if (cstr) s += cstr; return *this; }
+  String &operator+=(char c) { s += c; return *this; }
+  template <typename T> String &operator+=(T value) { return concat(String(value)); }
+  String &concat(const String &rhs) { s += rhs.s; return *this; }
+
+  bool equals(const String &rhs) const { return s == rhs.s; }
+  bool equals(const char *cstr) const { return s == (cstr ? cstr : ""); }
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *cstr) const { return equals(cstr); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *cstr) const { return !equals(cstr); }
+  bool operator<(const String &rhs) const { return s < rhs.s; }
+  bool equalsIgnoreCase(const String &rhs) const;
+  bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+  bool endsWith(const String &suffix) const;
+
+  char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index) { return s[index]; }
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const String &str, unsigned int from = 0) const;
+  int lastIndexOf(char c) const;
+  String substring(unsigned int left) const { return substring(left, s.size()); }
+  String substring(unsigned int left, unsigned int right) const;
+
+  void replace(const String &find, const String &replace);
+  void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+
+  long toInt() const { return atol(s.c_str()); }
+  float toFloat() const { return (float)atof(s.c_str()); }
+  double toDouble() const { return atof(s.c_str()); }
+
+private:
+  std::string s;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
+String operator+(const String &lhs, int rhs);
+String operator+(const String &lhs, unsigned int rhs);
+String operator+(const String &lhs, long rhs);
+String operator+(const String &lhs, unsigned long rhs);
+String operator+(const String &lhs, float rhs);
+String operator+(const String &lhs, double rhs);
+
+extern const String emptyString;
+
+#endif
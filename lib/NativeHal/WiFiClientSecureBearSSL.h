@@ -0,0 +1,18 @@
+#ifndef wificlientbearssl_h
+#define wificlientbearssl_h
+
+#include <ESP8266WiFi.h>
+#include <CertStoreBearSSL.h>
+
+namespace BearSSL {
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setCertStore(CertStore *certStore) {}
+  void setInsecure() {}
+  void setBufferSizes(int recv, int xmit) {}
+};
+
+}
+
+#endif
@@ -0,0 +1,26 @@
+// I2C is not used by the board; this satisfies libraries that include it
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <Arduino.h>
+
+class TwoWire : public Stream {
+public:
+  void begin() {}
+  void begin(int sda, int scl) {}
+  void setClock(uint32_t freq) {}
+  void beginTransmission(uint8_t address) {}
+  uint8_t endTransmission(bool sendStop = true) { return 2; }
+  uint8_t requestFrom(uint8_t address, size_t size, bool sendStop = true) { return 0; }
+  size_t write(uint8_t data) override { return 1; }
+  size_t write(const uint8_t *data, size_t quantity) override { return quantity; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  using Print::write;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef TOKEN_HELPER_H
+#define TOKEN_HELPER_H
+
+#include <Firebase.h>
+
+inline void tokenStatusCallback(TokenInfo info) {
+  Serial.printf("Token info: type = %d, status = %d\n", info.type, info.status);
+}
+
+#endif
@@ -0,0 +1,426 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <vector>
+
+#include "FirebaseJson.h"
+
+struct JsonValue {
+  enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_OBJECT, JSON_ARRAY };
+
+  Type type = JSON_NULL;
+  bool boolean = false;
+  std::string text;  // number literal or string contents
+  std::vector<std::pair<std::string, JsonValue> > members;
+  std::vector<JsonValue> elements;
+
+  JsonValue *member(const std::string &key) {
+    for (size_t i = 0; i < members.size(); i++) {
+      if (members[i].first == key) return &members[i].second;
+    }
+    return NULL;
+  }
+};
+
+// Parser
+
+class JsonParser {
+public:
+  explicit JsonParser(const std::string &s) : s(s), pos(0) {}
+
+  bool parse(JsonValue &out) {
+    if (!value(out)) return false;
+    ws();
+    return pos == s.size();
+  }
+
+private:
+  const std::string &s;
+  size_t pos;
+
+  void ws() {
+    while (pos < s.size() && isspace((unsigned char)s[pos])) pos++;
+  }
+
+  bool literal(const char *word) {
+    size_t n = strlen(word);
+    if (s.compare(pos, n, word) != 0) return false;
+    pos += n;
+    return true;
+  }
+
+  bool string(std::string &out) {
+    if (s[pos] != '"') return false;
+    pos++;
+    while (pos < s.size() && s[pos] != '"') {
+      char c = s[pos++];
+      if (c == '\\' && pos < s.size()) {
+        c = s[pos++];
+        switch (c) {
+          case 'n': c = '\n'; break;
+          case 'r': c = '\r'; break;
+          case 't': c = '\t'; break;
+          case 'b': c = '\b'; break;
+          case 'f': c = '\f'; break;
+          case 'u':
+            // Only the ASCII range is needed for configuration files
+            if (pos + 4 > s.size()) return false;
+            c = (char)strtol(s.substr(pos, 4).c_str(), NULL, 16);
+            pos += 4;
+            break;
+        }
+      }
+      out += c;
+    }
+    if (pos >= s.size()) return false;
+    pos++;
+    return true;
+  }
+
+  bool value(JsonValue &out) {
+    ws();
+    if (pos >= s.size()) return false;
+    char c = s[pos];
+    if (c == '{') {
+      out.type = JsonValue::JSON_OBJECT;
+      pos++;
+      ws();
+      if (pos < s.size() && s[pos] == '}') { pos++; return true; }
+      while (true) {
+        ws();
+        std::string key;
+        if (pos >= s.size() || !string(key)) return false;
+        ws();
+        if (pos >= s.size() || s[pos++] != ':') return false;
+        JsonValue member;
+        if (!value(member)) return false;
+        out.members.push_back(std::make_pair(key, member));
+        ws();
+        if (pos >= s.size()) return false;
+        if (s[pos] == ',') { pos++; continue; }
+        if (s[pos] == '}') { pos++; return true; }
+        return false;
+      }
+    }
+    if (c == '[') {
+      out.type = JsonValue::JSON_ARRAY;
+      pos++;
+      ws();
+      if (pos < s.size() && s[pos] == ']') { pos++; return true; }
+      while (true) {
+        JsonValue element;
+        if (!value(element)) return false;
+        out.elements.push_back(element);
+        ws();
+        if (pos >= s.size()) return false;
+        if (s[pos] == ',') { pos++; continue; }
+        if (s[pos] == ']') { pos++; return true; }
+        return false;
+      }
+    }
+    if (c == '"') {
+      out.type = JsonValue::JSON_STRING;
+      return string(out.text);
+    }
+    if (literal("true")) { out.type = JsonValue::JSON_BOOL; out.boolean = true; return true; }
+    if (literal("false")) { out.type = JsonValue::JSON_BOOL; out.boolean = false; return true; }
+    if (literal("null")) { out.type = JsonValue::JSON_NULL; return true; }
+    size_t start = pos;
+    while (pos < s.size() && (isdigit((unsigned char)s[pos]) || strchr("+-.eE", s[pos]))) pos++;
+    if (pos == start) return false;
+    out.type = JsonValue::JSON_NUMBER;
+    out.text = s.substr(start, pos - start);
+    return true;
+  }
+};
+
+// Serializer
+
+static void indent(std::string &out, int depth) {
+  out += '\n';
+  out.append(depth * 2, ' ');
+}
+
+static void quote(std::string &out, const std::string &text) {
+  out += '"';
+  for (size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+static void serialize(const JsonValue &v, std::string &out, bool pretty, int depth) {
+  switch (v.type) {
+    case JsonValue::JSON_NULL: out += "null"; break;
+    case JsonValue::JSON_BOOL: out += v.boolean ? "true" : "false"; break;
+    case JsonValue::JSON_NUMBER: out += v.text; break;
+    case JsonValue::JSON_STRING: quote(out, v.text); break;
+    case JsonValue::JSON_OBJECT:
+      out += '{';
+      for (size_t i = 0; i < v.members.size(); i++) {
+        if (i) out += ',';
+        if (pretty) indent(out, depth + 1);
+        quote(out, v.members[i].first);
+        out += pretty ? ": " : ":";
+        serialize(v.members[i].second, out, pretty, depth + 1);
+      }
+      if (pretty && !v.members.empty()) indent(out, depth);
+      out += '}';
+      break;
+    case JsonValue::JSON_ARRAY:
+      out += '[';
+      for (size_t i = 0; i < v.elements.size(); i++) {
+        if (i) out += ',';
+        if (pretty) indent(out, depth + 1);
+        serialize(v.elements[i], out, pretty, depth + 1);
+      }
+      if (pretty && !v.elements.empty()) indent(out, depth);
+      out += ']';
+      break;
+  }
+}
+
+// Paths look like "a/b/[2]/c"; a leading slash is optional
+
+static std::vector<std::string> splitPath(const String &path) {
+  std::vector<std::string> parts;
+  const std::string &p = path.str();
+  size_t start = 0;
+  while (start <= p.size()) {
+    size_t end = p.find('/', start);
+    if (end == std::string::npos) end = p.size();
+    if (end > start) parts.push_back(p.substr(start, end - start));
+    start = end + 1;
+  }
+  return parts;
+}
+
+static bool arrayIndex(const std::string &part, size_t &index) {
+  if (part.size() < 3 || part[0] != '[' || part[part.size() - 1] != ']') return false;
+  index = strtoul(part.c_str() + 1, NULL, 10);
+  return true;
+}
+
+static JsonValue *find(JsonValue *v, const std::vector<std::string> &parts, bool create) {
+  for (size_t i = 0; i < parts.size(); i++) {
+    size_t index;
+    if (arrayIndex(parts[i], index)) {
+      if (v->type != JsonValue::JSON_ARRAY) {
+        if (!create) return NULL;
+        *v = JsonValue();
+        v->type = JsonValue::JSON_ARRAY;
+      }
+      if (index >= v->elements.size()) {
+        if (!create) return NULL;
+        v->elements.resize(index + 1);
+      }
+      v = &v->elements[index];
+    } else {
+      if (v->type != JsonValue::JSON_OBJECT) {
+        if (!create) return NULL;
+        *v = JsonValue();
+        v->type = JsonValue::JSON_OBJECT;
+      }
+      JsonValue *child = v->member(parts[i]);
+      if (!child) {
+        if (!create) return NULL;
+        v->members.push_back(std::make_pair(parts[i], JsonValue()));
+        child = &v->members.back().second;
+      }
+      v = child;
+    }
+  }
+  return v;
+}
+
+// As cJSON in the library, NAN and infinities go out as null
+
+static JsonValue number(double value) {
+  JsonValue v;
+  if (!isfinite(value)) return v;
+  v.type = JsonValue::JSON_NUMBER;
+  char buf[32];
+  if (value == (long long)value && fabs(value) < 1e15) {
+    snprintf(buf, sizeof(buf), "%lld", (long long)value);
+  } else {
+    snprintf(buf, sizeof(buf), "%.9g", value);
+  }
+  v.text = buf;
+  return v;
+}
+
+static JsonValue text(const String &value) {
+  JsonValue v;
+  v.type = JsonValue::JSON_STRING;
+  v.text = value.str();
+  return v;
+}
+
+static JsonValue flag(bool value) {
+  JsonValue v;
+  v.type = JsonValue::JSON_BOOL;
+  v.boolean = value;
+  return v;
+}
+
+// FirebaseJson
+
+FirebaseJson::FirebaseJson() : root(new JsonValue()) {
+  root->type = JsonValue::JSON_OBJECT;
+}
+
+FirebaseJson::FirebaseJson(const FirebaseJson &other) : root(new JsonValue(*other.root)) {}
+
+FirebaseJson &FirebaseJson::operator=(const FirebaseJson &other) {
+  if (this != &other) *root = *other.root;
+  return *this;
+}
+
+FirebaseJson::~FirebaseJson() {
+  delete root;
+}
+
+FirebaseJson &FirebaseJson::add(const String &key, const String &value) {
+  root->members.push_back(std::make_pair(key.str(), text(value)));
+  return *this;
+}
+
+FirebaseJson &FirebaseJson::add(const String &key, double value) {
+  root->members.push_back(std::make_pair(key.str(), number(value)));
+  return *this;
+}
+
+FirebaseJson &FirebaseJson::add(const String &key, bool value) {
+  root->members.push_back(std::make_pair(key.str(), flag(value)));
+  return *this;
+}
+
+FirebaseJson &FirebaseJson::add(const String &key, const FirebaseJson &value) {
+  root->members.push_back(std::make_pair(key.str(), *value.root));
+  return *this;
+}
+
+void FirebaseJson::set(const String &path, const String &value) {
+  *find(root, splitPath(path), true) = text(value);
+}
+
+void FirebaseJson::set(const String &path, double value) {
+  *find(root, splitPath(path), true) = number(value);
+}
+
+void FirebaseJson::set(const String &path, bool value) {
+  *find(root, splitPath(path), true) = flag(value);
+}
+
+void FirebaseJson::set(const String &path, const FirebaseJson &value) {
+  *find(root, splitPath(path), true) = *value.root;
+}
+
+bool FirebaseJson::get(FirebaseJsonData &result, const String &path, bool prettify) {
+  result = FirebaseJsonData();
+  const JsonValue *v = find(root, splitPath(path), false);
+  if (!v) return false;
+  result.success = true;
+  switch (v->type) {
+    case JsonValue::JSON_NULL:
+      result.type = "null";
+      break;
+    case JsonValue::JSON_BOOL:
+      result.type = "boolean";
+      result.boolValue = v->boolean;
+      result.intValue = v->boolean;
+      result.stringValue = v->boolean ? "true" : "false";
+      break;
+    case JsonValue::JSON_NUMBER:
+      result.type = v->text.find_first_of(".eE") == std::string::npos ? "int" : "double";
+      result.stringValue = String(v->text);
+      result.doubleValue = atof(v->text.c_str());
+      result.floatValue = (float)result.doubleValue;
+      result.intValue = (int)result.doubleValue;
+      result.boolValue = result.doubleValue != 0;
+      break;
+    case JsonValue::JSON_STRING:
+      result.type = "string";
+      result.stringValue = String(v->text);
+      break;
+    case JsonValue::JSON_OBJECT:
+    case JsonValue::JSON_ARRAY: {
+      result.type = v->type == JsonValue::JSON_OBJECT ? "object" : "array";
+      std::string out;
+      serialize(*v, out, prettify, 0);
+      result.stringValue = String(out);
+      break;
+    }
+  }
+  return true;
+}
+
+bool FirebaseJson::remove(const String &path) {
+  std::vector<std::string> parts = splitPath(path);
+  if (parts.empty()) return false;
+  std::string last = parts.back();
+  parts.pop_back();
+  JsonValue *parent = find(root, parts, false);
+  if (!parent) return false;
+  for (size_t i = 0; i < parent->members.size(); i++) {
+    if (parent->members[i].first == last) {
+      parent->members.erase(parent->members.begin() + i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void FirebaseJson::clear() {
+  *root = JsonValue();
+  root->type = JsonValue::JSON_OBJECT;
+}
+
+bool FirebaseJson::readFrom(Stream &stream) {
+  return setJsonData(stream.readString());
+}
+
+bool FirebaseJson::setJsonData(const String &data) {
+  JsonValue parsed;
+  JsonParser parser(data.str());
+  if (!parser.parse(parsed)) {
+    clear();
+    return false;
+  }
+  *root = parsed;
+  return true;
+}
+
+bool FirebaseJson::toString(Print &out, bool prettify) {
+  String s;
+  toString(s, prettify);
+  out.print(s);
+  return true;
+}
+
+bool FirebaseJson::toString(String &out, bool prettify) {
+  std::string s;
+  serialize(*root, s, prettify, 0);
+  out = String(s);
+  return true;
+}
+
+String FirebaseJson::raw() {
+  String s;
+  toString(s);
+  return s;
+}
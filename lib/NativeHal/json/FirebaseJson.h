@@ -0,0 +1,73 @@
+// Subset of FirebaseJson used by the firmware: parse, query by path,
+// build and serialize.
+
+#ifndef FirebaseJson_H
+#define FirebaseJson_H
+
+#include <Arduino.h>
+
+struct JsonValue;
+
+class FirebaseJsonData {
+public:
+  bool success = false;
+  String type;
+  String stringValue;
+  int intValue = 0;
+  float floatValue = 0;
+  double doubleValue = 0;
+  bool boolValue = false;
+
+  template <typename T> T to();
+};
+
+template <> inline String FirebaseJsonData::to<String>() { return stringValue; }
+template <> inline int FirebaseJsonData::to<int>() { return intValue; }
+template <> inline float FirebaseJsonData::to<float>() { return floatValue; }
+template <> inline double FirebaseJsonData::to<double>() { return doubleValue; }
+template <> inline bool FirebaseJsonData::to<bool>() { return boolValue; }
+
+class FirebaseJson {
+public:
+  FirebaseJson();
+  FirebaseJson(const FirebaseJson &other);
+  FirebaseJson &operator=(const FirebaseJson &other);
+  ~FirebaseJson();
+
+  FirebaseJson &add(const String &key, const char *value) { return add(key, String(value)); }
+  FirebaseJson &add(const String &key, const String &value);
+  FirebaseJson &add(const String &key, int value) { return add(key, (double)value); }
+  FirebaseJson &add(const String &key, unsigned int value) { return add(key, (double)value); }
+  FirebaseJson &add(const String &key, long value) { return add(key, (double)value); }
+  FirebaseJson &add(const String &key, unsigned long value) { return add(key, (double)value); }
+  FirebaseJson &add(const String &key, float value) { return add(key, (double)value); }
+  FirebaseJson &add(const String &key, double value);
+  FirebaseJson &add(const String &key, bool value);
+  FirebaseJson &add(const String &key, const FirebaseJson &value);
+
+  void set(const String &path, const char *value) { set(path, String(value)); }
+  void set(const String &path, const String &value);
+  void set(const String &path, int value) { set(path, (double)value); }
+  void set(const String &path, unsigned int value) { set(path, (double)value); }
+  void set(const String &path, long value) { set(path, (double)value); }
+  void set(const String &path, unsigned long value) { set(path, (double)value); }
+  void set(const String &path, float value) { set(path, (double)value); }
+  void set(const String &path, double value);
+  void set(const String &path, bool value);
+  void set(const String &path, const FirebaseJson &value);
+
+  bool get(FirebaseJsonData &result, const String &path, bool prettify = false);
+  bool remove(const String &path);
+  void clear();
+
+  bool readFrom(Stream &stream);
+  bool setJsonData(const String &data);
+  bool toString(Print &out, bool prettify = false);
+  bool toString(String &out, bool prettify = false);
+  String raw();
+
+private:
+  JsonValue *root;
+};
+
+#endif
@@ -0,0 +1,30 @@
+// Pin names of the Wemos D1 mini pro
+
+#ifndef Pins_Arduino_h
+#define Pins_Arduino_h
+
+#define NUM_DIGITAL_PINS 17
+#define NUM_ANALOG_INPUTS 1
+
+#define LED_BUILTIN 2
+
+static const uint8_t A0 = 17;
+
+static const uint8_t D0 = 16;
+static const uint8_t D1 = 5;
+static const uint8_t D2 = 4;
+static const uint8_t D3 = 0;
+static const uint8_t D4 = 2;
+static const uint8_t D5 = 14;
+static const uint8_t D6 = 12;
+static const uint8_t D7 = 13;
+static const uint8_t D8 = 15;
+
+static const uint8_t SS = 15;
+static const uint8_t MOSI = 13;
+static const uint8_t MISO = 12;
+static const uint8_t SCK = 14;
+
+#define digitalPinToBitMask(pin) (1UL << (pin))
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef WiringPrivate_h
+#define WiringPrivate_h
+
+#include "Arduino.h"
+
+#endif
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+
+# Runs the native build against the simulated kettle once per control mode
+# and tabulates the step response of the water towards a set point, with
+# the number of SSR switching edges. Build first with `pio run -e native`.
+#
+# Manual mode runs open loop at the pot setting that holds the set point
+# once settled, i.e. the losses at the set point over the heater power.
+#
+#   scripts/kettle-bench.py
+#   scripts/kettle-bench.py --kettle 30:3500:10 --start 15 --target 67 --duration 10800
+import argparse
+import re
+import subprocess
+import sys
+
+MODES = [
+    ('manual', ['controlState=1']),
+    ('pid', ['controlState=2']),
+    ('pid-sigma-delta', ['controlState=2', 'ssrMode=1']),
+]
+
+# As SIM_KETTLE_LOSS and SIM_AMBIENT in lib/NativeHal/SimMain.cpp
+
+DEFAULT_LOSS = 8.0
+AMBIENT = 20.0
+
+# Inputs are streamed once the firmware is online
+
+INPUT_AT = 3
+
+
+def run(args, mode_inputs, pot):
+    cmd = [args.program, '--fs', args.fs, '--quiet', '--duration', str(args.duration),
+           '--temp', str(args.start), '--kettle', args.kettle, '--target', str(args.target),
+           '--pot', str(pot), '--input', 'setPoint=%g@%d' % (args.target, INPUT_AT)]
+    for i in mode_inputs:
+        cmd += ['--input', '%s@%d' % (i, INPUT_AT)]
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+    step = re.search(r'rise time (\S+?)(?: s)?, overshoot (\S+) C, settling time (\S+?)(?: s)?$',
+                     out, re.M)
+    edges = re.search(r'^SSR: (\d+) edges', out, re.M)
+    water = re.search(r'^Kettle: .*water (\S+) C', out, re.M)
+    if not step or not edges or not water:
+        raise RuntimeError('no kettle report from ' + ' '.join(cmd))
+    return step.group(1), step.group(2), step.group(3), edges.group(1), water.group(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare control modes on the simulated kettle')
+    parser.add_argument('--program', default='.pio/build/native/program',
+                        help='native build of the firmware')
+    parser.add_argument('--fs', default='data', help='directory used as LittleFS')
+    parser.add_argument('--kettle', default='20:2000', help='L:W[:LOSS[:LAG[:DEAD]]] as for the program')
+    parser.add_argument('--start', type=float, default=20, help='starting water temperature, C')
+    parser.add_argument('--target', type=float, default=65, help='set point, C')
+    parser.add_argument('--duration', type=float, default=7200, help='simulated seconds per run')
+    args = parser.parse_args()
+
+    fields = args.kettle.split(':')
+    watts = float(fields[1])
+    loss = float(fields[2]) if len(fields) > 2 else DEFAULT_LOSS
+    pot = round(min(max(loss * (args.target - AMBIENT) / watts, 0), 1) * 1024)
+
+    print('%-16s %10s %10s %12s %10s %8s' % ('mode', 'rise s', 'overshoot', 'settling s',
+                                             'ssr edges', 'final C'))
+    for name, inputs in MODES:
+        rise, overshoot, settling, edges, water = run(args, inputs, pot)
+        print('%-16s %10s %10s %12s %10s %8s' % (name, rise, overshoot, settling, edges, water))
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
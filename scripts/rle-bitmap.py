@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+
+# Converts a monochrome image to the run-length encoding drawn by
+# Adafruit_ILI9341::drawRLEBitmap() and prints it as a PROGMEM C array.
+#
+# The encoding covers the image row by row as alternating runs of
+# background and foreground pixels, starting with background. Each byte is
+# the length of one run; a run longer than 255 pixels is written as 255, a
+# zero-length run of the other color, and the remainder.
+#
+# Input is a netpbm image (PBM, PGM or PPM, plain or raw; any pixel darker
+# than half intensity is foreground, or lighter with --invert), or with
+# --bitmap W H the hex bytes of an Adafruit_GFX drawBitmap() array.
+#
+#   scripts/rle-bitmap.py icon.pbm wifi_icon
+#   scripts/rle-bitmap.py --bitmap 40 30 wifi_bitmap_1 < bytes.txt
+import argparse
+import re
+import sys
+
+
+def read_netpbm(path, invert):
+    with open(path, 'rb') as f:
+        data = f.read()
+    tokens = []
+    pos = 0
+    # Header: magic, width, height and (except for PBM) maxval
+    while len(tokens) < (3 if data[:2] in (b'P1', b'P4') else 4):
+        m = re.compile(rb'\s*(#[^\n]*\n\s*)*(\S+)').match(data, pos)
+        if not m:
+            raise ValueError('truncated header in ' + path)
+        tokens.append(m.group(2))
+        pos = m.end()
+    magic = tokens[0].decode()
+    width, height = int(tokens[1]), int(tokens[2])
+    maxval = int(tokens[3]) if len(tokens) > 3 else 1
+    body = data[pos + 1:]
+
+    pixels = []
+    if magic == 'P1':
+        bits = [c for c in data[pos:].decode() if c in '01']
+        pixels = [b == '1' for b in bits[:width * height]]
+    elif magic == 'P4':
+        stride = (width + 7) // 8
+        for y in range(height):
+            row = body[y * stride:(y + 1) * stride]
+            pixels += [bool(row[x // 8] & (0x80 >> (x % 8))) for x in range(width)]
+    elif magic in ('P2', 'P3'):
+        values = [int(v) for v in data[pos:].split()]
+        step = 3 if magic == 'P3' else 1
+        for i in range(width * height):
+            pixels.append(sum(values[i * step:(i + 1) * step]) / step < maxval / 2)
+    elif magic in ('P5', 'P6'):
+        step = 3 if magic == 'P6' else 1
+        for i in range(width * height):
+            pixels.append(sum(body[i * step:(i + 1) * step]) / step < maxval / 2)
+    else:
+        raise ValueError('unsupported image type ' + magic)
+    if invert:
+        pixels = [not p for p in pixels]
+    return width, height, pixels
+
+
+def read_bitmap(width, height, text):
+    values = [int(v, 16) for v in re.findall(r'0[xX]([0-9a-fA-F]{1,2})', text)]
+    stride = (width + 7) // 8
+    if len(values) < stride * height:
+        raise ValueError('expected %d bytes, got %d' % (stride * height, len(values)))
+    pixels = []
+    for y in range(height):
+        row = values[y * stride:(y + 1) * stride]
+        pixels += [bool(row[x // 8] & (0x80 >> (x % 8))) for x in range(width)]
+    return pixels
+
+
+def encode(pixels):
+    out = []
+    color = False
+    i = 0
+    while i < len(pixels):
+        run = 0
+        while i < len(pixels) and pixels[i] == color:
+            run += 1
+            i += 1
+        while run > 255:
+            out += [255, 0]
+            run -= 255
+        out.append(run)
+        color = not color
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert an image to an RLE bitmap for drawRLEBitmap()')
+    parser.add_argument('--bitmap', nargs=2, type=int, metavar=('W', 'H'),
+                        help='read drawBitmap() hex bytes of a WxH image from stdin')
+    parser.add_argument('--invert', action='store_true', help='light pixels are foreground')
+    parser.add_argument('input', nargs='?', help='netpbm image')
+    parser.add_argument('name', help='name of the C array')
+    args = parser.parse_args()
+
+    if args.bitmap:
+        width, height = args.bitmap
+        pixels = read_bitmap(width, height, sys.stdin.read())
+        if args.invert:
+            pixels = [not p for p in pixels]
+    elif args.input:
+        width, height, pixels = read_netpbm(args.input, args.invert)
+    else:
+        parser.error('an input image or --bitmap is required')
+
+    data = encode(pixels)
+    print('// \'%s\', %dx%dpx, RLE (%d bytes, %d as a bitmap)' %
+          (args.name, width, height, len(data), (width + 7) // 8 * height))
+    print()
+    print('const unsigned char %s [] PROGMEM = {' % args.name)
+    for i in range(0, len(data), 16):
+        print('\t' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    print('};')
+
+
+if __name__ == '__main__':
+    main()
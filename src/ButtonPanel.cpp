@@ -0,0 +1,145 @@
+#include "ButtonPanel.h"
+
+// Palette indices of a button surface
+
+#define INDEX_BG 0
+#define INDEX_OUTLINE 1
+#define INDEX_FILL 2
+#define INDEX_TEXT 3
+
+// Longest run held by one byte of a surface
+
+#define MAX_RUN 64
+
+// Off-screen target for rendering a button with the GFX primitives. Colors
+// are palette indices, stored at two bits per pixel.
+
+class IndexCanvas : public Adafruit_GFX {
+public:
+  IndexCanvas(int16_t w, int16_t h) : Adafruit_GFX(w, h) {
+    pixels = (uint8_t *)calloc(((int32_t)w * h + 3) / 4, 1);
+  }
+  ~IndexCanvas() {
+    free(pixels);
+  }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    if (!pixels || x < 0 || y < 0 || x >= _width || y >= _height) return;
+    int32_t i = (int32_t)y * _width + x;
+    uint8_t shift = (i % 4) * 2;
+    pixels[i / 4] = (pixels[i / 4] & ~(3 << shift)) | (color & 3) << shift;
+  }
+  uint8_t index(int32_t i) {
+    return pixels[i / 4] >> ((i % 4) * 2) & 3;
+  }
+  bool ok() {
+    return pixels != NULL;
+  }
+private:
+  uint8_t *pixels;
+};
+
+// Encode the canvas for Adafruit_ILI9341::drawIndexedRLE(): one byte per
+// run, index in the top two bits and length minus one below. Called with
+// out == NULL it only counts the bytes needed.
+
+static uint16_t encode(IndexCanvas &canvas, int32_t n, uint8_t *out) {
+  uint16_t len = 0;
+  int32_t i = 0;
+  while (i < n) {
+    uint8_t index = canvas.index(i);
+    uint8_t run = 1;
+    while (i + run < n && run < MAX_RUN && canvas.index(i + run) == index) run++;
+    if (out) out[len] = index << 6 | (run - 1);
+    len++;
+    i += run;
+  }
+  return len;
+}
+
+ButtonPanel::ButtonPanel(uint16_t bg) : bg(bg), nButtons(0), changeMillis(0) {}
+
+ButtonPanel::~ButtonPanel() {
+  clear();
+}
+
+// Add a button centered on x, y, laid out like Adafruit_GFX_Button. Returns
+// its index, or -1 if the panel is full or out of memory.
+
+int8_t ButtonPanel::add(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t outline,
+                        uint16_t fill, uint16_t textColor, const char *label, uint8_t textSize) {
+  if (nButtons >= BUTTON_PANEL_MAX) return -1;
+
+  IndexCanvas canvas(w, h);
+  if (!canvas.ok()) return -1;
+  int16_t r = min(w, h) / 4;
+  canvas.fillRoundRect(0, 0, w, h, r, INDEX_FILL);
+  canvas.drawRoundRect(0, 0, w, h, r, INDEX_OUTLINE);
+  canvas.setTextWrap(false);
+  canvas.setTextColor(INDEX_TEXT);
+  canvas.setTextSize(textSize);
+  canvas.setCursor(w / 2 - strlen(label) * 3 * textSize, h / 2 - 4 * textSize);
+  canvas.print(label);
+
+  int32_t n = (int32_t)w * h;
+  uint8_t *surface = (uint8_t *)malloc(encode(canvas, n, NULL));
+  if (!surface) return -1;
+  encode(canvas, n, surface);
+
+  Button &b = buttons[nButtons];
+  b.x = x - w / 2;
+  b.y = y - h / 2;
+  b.w = w;
+  b.h = h;
+  b.palette[INDEX_BG] = b.inverted[INDEX_BG] = bg;
+  b.palette[INDEX_OUTLINE] = b.inverted[INDEX_OUTLINE] = outline;
+  b.palette[INDEX_FILL] = b.inverted[INDEX_TEXT] = fill;
+  b.palette[INDEX_TEXT] = b.inverted[INDEX_FILL] = textColor;
+  b.surface = surface;
+  b.pressed = false;
+  return nButtons++;
+}
+
+// Remove all buttons, e.g. before switching to another screen
+
+void ButtonPanel::clear() {
+  for (uint8_t b = 0; b < nButtons; b++) {
+    free(buttons[b].surface);
+  }
+  nButtons = 0;
+}
+
+uint8_t ButtonPanel::size() {
+  return nButtons;
+}
+
+void ButtonPanel::drawButton(Adafruit_ILI9341 *pTft, uint8_t b) {
+  const Button &button = buttons[b];
+  pTft->drawIndexedRLE(button.x, button.y, button.surface, button.w, button.h,
+                       button.pressed ? button.inverted : button.palette);
+}
+
+void ButtonPanel::draw(Adafruit_ILI9341 *pTft) {
+  for (uint8_t b = 0; b < nButtons; b++) {
+    drawButton(pTft, b);
+  }
+}
+
+// Track the touch position, redrawing buttons as they are pressed and
+// released. Returns the index of a button that has just been pressed, or -1.
+// Changes within BUTTON_DEBOUNCE_TIME of the last one are ignored.
+
+int8_t ButtonPanel::update(Adafruit_ILI9341 *pTft, bool touching, int16_t x, int16_t y) {
+  if (millis() - changeMillis < BUTTON_DEBOUNCE_TIME) return -1;
+  int8_t justPressed = -1;
+  for (uint8_t b = 0; b < nButtons; b++) {
+    Button &button = buttons[b];
+    bool inside = touching && x >= button.x && x < button.x + button.w &&
+                  y >= button.y && y < button.y + button.h;
+    if (inside == button.pressed) continue;
+    button.pressed = inside;
+    drawButton(pTft, b);
+    changeMillis = millis();
+    if (inside && justPressed < 0) justPressed = b;
+  }
+  return justPressed;
+}
@@ -0,0 +1,37 @@
+// Set of touch buttons for the setup screens. Each button is rendered once,
+// when it is added, into a run-length encoded four-color surface, so drawing
+// it normal or inverted is a single blit with one of two palettes. Presses
+// are debounced by time instead of by blocking the loop.
+
+#include <Arduino.h>
+
+#include "Adafruit_ILI9341esp.h"
+
+#define BUTTON_PANEL_MAX 3
+#define BUTTON_DEBOUNCE_TIME 100
+
+class ButtonPanel {
+public:
+  ButtonPanel(uint16_t bg = ILI9341_BLACK);
+  ~ButtonPanel();
+  int8_t add(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t outline, uint16_t fill,
+             uint16_t textColor, const char *label, uint8_t textSize);
+  void clear();
+  void draw(Adafruit_ILI9341 *pTft);
+  int8_t update(Adafruit_ILI9341 *pTft, bool touching, int16_t x, int16_t y);
+  uint8_t size();
+private:
+  struct Button {
+    int16_t x, y;  // top left corner
+    uint16_t w, h;
+    uint16_t palette[4];
+    uint16_t inverted[4];
+    uint8_t *surface;
+    bool pressed;
+  };
+  void drawButton(Adafruit_ILI9341 *pTft, uint8_t b);
+  uint16_t bg;
+  Button buttons[BUTTON_PANEL_MAX];
+  uint8_t nButtons;
+  unsigned long changeMillis;
+};
@@ -0,0 +1,63 @@
+#include "FilterChain.h"
+
+// Division rounding to nearest for either sign
+
+static int32_t roundedDiv(int32_t n, int32_t d) {
+  return (n >= 0 ? n + d / 2 : n - d / 2) / d;
+}
+
+FilterChain::FilterChain(uint8_t oversample, uint8_t median, uint8_t iirShift)
+  : oversample(max(oversample, (uint8_t) 1)),
+    medianLen(constrain(median, 1, FILTER_MEDIAN_MAX)), iirShift(iirShift) {
+  reset();
+}
+
+void FilterChain::reset() {
+  sum = 0;
+  nSummed = 0;
+  historyNext = historyLen = 0;
+  iirState = 0;
+  primed = false;
+}
+
+// Feed one raw sample. Returns true if it completed an oversampling group,
+// i.e. value() has been updated.
+
+bool FilterChain::add(int32_t sample) {
+  sum += sample;
+  if (++nSummed < oversample) return false;
+  int32_t average = roundedDiv(sum, oversample);
+  sum = 0;
+  nSummed = 0;
+
+  history[historyNext] = average;
+  historyNext = (historyNext + 1) % medianLen;
+  if (historyLen < medianLen) historyLen++;
+
+  int32_t x = median() * (1 << FILTER_IIR_FRACTION_BITS);
+  if (!primed) {
+    iirState = x;
+    primed = true;
+  } else {
+    iirState += (x - iirState) >> iirShift;
+  }
+  return true;
+}
+
+// Filtered value, 0 until the first group is complete
+
+int32_t FilterChain::value() const {
+  return roundedDiv(iirState, 1 << FILTER_IIR_FRACTION_BITS);
+}
+
+// Median of the history, the lower middle one while it holds an even count
+
+int32_t FilterChain::median() const {
+  int32_t sorted[FILTER_MEDIAN_MAX];
+  for (uint8_t i = 0; i < historyLen; i++) {
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > history[i]; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = history[i];
+  }
+  return sorted[(historyLen - 1) / 2];
+}
@@ -0,0 +1,38 @@
+// Conditioning for one sensor channel, fed at a fixed sample rate. Samples
+// pass through up to three stages, each optional:
+//
+//   oversample  averages groups of n samples and passes on one per group,
+//               dividing the output rate by n
+//   median      the median of the last n averages, which rejects isolated
+//               outliers such as a corrupted SPI transfer
+//   IIR         first-order low pass, y += (x - y) / 2^shift, a time
+//               constant of about 2^shift outputs
+//
+// Values are integers in the channel's own units; the IIR keeps
+// FILTER_IIR_FRACTION_BITS extra bits so small steps aren't lost. Until the
+// stages have seen enough samples they work on what they have, so the first
+// output follows the first group of samples.
+
+#include <Arduino.h>
+
+#define FILTER_MEDIAN_MAX 5
+#define FILTER_IIR_FRACTION_BITS 8
+
+class FilterChain {
+public:
+  FilterChain(uint8_t oversample = 1, uint8_t median = 1, uint8_t iirShift = 0);
+  bool add(int32_t sample);
+  int32_t value() const;
+  bool valid() const { return primed; }
+  void reset();
+private:
+  int32_t median() const;
+
+  uint8_t oversample, medianLen, iirShift;
+  int32_t sum;
+  uint8_t nSummed;
+  int32_t history[FILTER_MEDIAN_MAX];
+  uint8_t historyNext, historyLen;
+  int32_t iirState;
+  bool primed;
+};
@@ -0,0 +1,57 @@
+#include "GainSchedule.h"
+
+GainSchedule::GainSchedule(double kp, double ki, double kd) {
+  for (uint8_t i = 0; i < GAIN_BANDS; i++) bands[i] = { kp, ki, kd, 0, 0 };
+}
+
+// Read gains saved by save(), keeping the current ones for bands the file
+// doesn't cover. Returns false if there is no file.
+
+bool GainSchedule::load(const char *path) {
+  File f = LittleFS.open(path, "r");
+  if (!f) return false;
+  FirebaseJson json;
+  json.readFrom(f);
+  f.close();
+  PidGains all;
+  if (readGains(json, "", all)) {
+    for (uint8_t i = 0; i < GAIN_BANDS; i++) bands[i] = all;
+  }
+  for (uint8_t i = 0; i < GAIN_BANDS; i++) {
+    readGains(json, String(bandName(i)) + "/", bands[i]);
+  }
+  return true;
+}
+
+bool GainSchedule::save(const char *path) const {
+  FirebaseJson json;
+  for (uint8_t i = 0; i < GAIN_BANDS; i++) {
+    FirebaseJson band;
+    band.add("kp", bands[i].kp);
+    band.add("ki", bands[i].ki);
+    band.add("kd", bands[i].kd);
+    if (bands[i].ku) {
+      band.add("ku", bands[i].ku);
+      band.add("pu", bands[i].pu);
+    }
+    json.add(bandName(i), band);
+  }
+  File f = LittleFS.open(path, "w");
+  if (!f) return false;
+  json.toString(f, true);
+  f.close();
+  return true;
+}
+
+bool GainSchedule::readGains(FirebaseJson &json, const String &prefix, PidGains &gains) {
+  FirebaseJsonData kp, ki, kd, ku, pu;
+  if (!json.get(kp, prefix + "kp") || !json.get(ki, prefix + "ki") || !json.get(kd, prefix + "kd")) {
+    return false;
+  }
+  gains.kp = kp.to<double>();
+  gains.ki = ki.to<double>();
+  gains.kd = kd.to<double>();
+  gains.ku = json.get(ku, prefix + "ku") ? ku.to<double>() : 0;
+  gains.pu = json.get(pu, prefix + "pu") ? pu.to<double>() : 0;
+  return true;
+}
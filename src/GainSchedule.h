@@ -0,0 +1,34 @@
+// PID gains per temperature band of the set point. Mash rests and the
+// approach to the boil see quite different losses, so each band has its own
+// gains, tuned by running an autotune at a set point in that band. Bands
+// without tuned gains use the defaults.
+//
+// Stored as JSON with an object per band, each holding kp, ki and kd, and
+// ku and pu when they came from an autotune. Gains at the top level, as
+// written before there were bands, apply to every band.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <json/FirebaseJson.h>
+
+#define GAIN_BANDS 2
+#define GAIN_BAND_SPLIT 80  // C, set points from here up use the high band
+
+struct PidGains {
+  double kp, ki, kd;
+  double ku, pu;  // 0 if not from an autotune
+};
+
+class GainSchedule {
+public:
+  GainSchedule(double kp, double ki, double kd);
+  uint8_t bandOf(double setPoint) const { return setPoint < GAIN_BAND_SPLIT ? 0 : 1; }
+  const char *bandName(uint8_t band) const { return band ? "high" : "low"; }
+  const PidGains &gains(uint8_t band) const { return bands[band]; }
+  void setGains(uint8_t band, const PidGains &gains) { bands[band] = gains; }
+  bool load(const char *path);
+  bool save(const char *path) const;
+private:
+  static bool readGains(FirebaseJson &json, const String &prefix, PidGains &gains);
+  PidGains bands[GAIN_BANDS];
+};
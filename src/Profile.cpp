@@ -0,0 +1,112 @@
+#include "Profile.h"
+
+Profile::Profile()
+  : nSteps(0), current(0), profileState(PROFILE_IDLE), setPoint(0), lastMillis(0),
+    holdStartMillis(0) {}
+
+// Read the steps from path and stop the profile. Returns false, leaving the
+// profile as it was, e.g. still running, if there is no file or it has no
+// steps.
+
+bool Profile::load(const char *path) {
+  File f = LittleFS.open(path, "r");
+  if (!f) return false;
+  FirebaseJson json;
+  json.readFrom(f);
+  f.close();
+  FirebaseJsonData target, result;
+  Step steps[PROFILE_MAX_STEPS];
+  uint8_t n = 0;
+  while (n < PROFILE_MAX_STEPS) {
+    String prefix = "steps/[" + String(n) + "]/";
+    if (!json.get(target, prefix + "target")) break;
+    Step &s = steps[n];
+    String name = json.get(result, prefix + "name") ? result.to<String>() : "Step " + String(n + 1);
+    strncpy(s.name, name.c_str(), PROFILE_NAME_LEN - 1);
+    s.name[PROFILE_NAME_LEN - 1] = 0;
+    s.target = target.to<float>();
+    s.rampRate = json.get(result, prefix + "ramp") ? max(result.to<float>(), 0.0f) / 60 : 0;
+    s.holdMs = json.get(result, prefix + "hold") ? max(result.to<float>(), 0.0f) * 60000 : 0;
+    s.within = json.get(result, prefix + "within") ? result.to<float>() : PROFILE_WITHIN;
+    n++;
+  }
+  if (!n) return false;
+  memcpy(stepList, steps, n * sizeof(Step));
+  nSteps = n;
+  current = 0;
+  profileState = PROFILE_IDLE;
+  return true;
+}
+
+// Run the profile from the first step, ramping from setPoint
+
+void Profile::start(double setPoint) {
+  if (!nSteps) return;
+  this->setPoint = setPoint;
+  lastMillis = millis();
+  enter(0);
+}
+
+void Profile::enter(uint8_t step) {
+  current = step;
+  profileState = stepList[step].rampRate > 0 ? PROFILE_RAMP : PROFILE_WAIT;
+  if (profileState == PROFILE_WAIT) setPoint = stepList[step].target;
+}
+
+// Advance the profile given the kettle temperature, NAN if unknown, and
+// return the set point. The hold timer only starts once the temperature is
+// within the step's band of the target.
+
+double Profile::update(double temperature) {
+  uint32_t now = millis();
+  float dt = (now - lastMillis) / 1000.0;
+  lastMillis = now;
+  if (!running()) return setPoint;
+
+  const Step &s = stepList[current];
+  switch (profileState) {
+    case PROFILE_RAMP:
+      if (setPoint < s.target) {
+        setPoint = min((double) s.target, setPoint + s.rampRate * dt);
+      } else {
+        setPoint = max((double) s.target, setPoint - s.rampRate * dt);
+      }
+      if (setPoint == s.target) profileState = PROFILE_WAIT;
+      break;
+    case PROFILE_WAIT:
+      if (!isnan(temperature) && fabs(temperature - s.target) <= s.within) {
+        profileState = PROFILE_HOLD;
+        holdStartMillis = now;
+      }
+      break;
+    case PROFILE_HOLD:
+      if (now - holdStartMillis >= s.holdMs) {
+        if (current + 1 < nSteps) {
+          enter(current + 1);
+        } else {
+          profileState = PROFILE_DONE;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+  return setPoint;
+}
+
+// Seconds until the current step ends: what is left of the ramp and the
+// hold, or just the hold while waiting for the temperature. -1 when not
+// running.
+
+int32_t Profile::remaining() const {
+  if (!running()) return -1;
+  const Step &s = stepList[current];
+  switch (profileState) {
+    case PROFILE_RAMP:
+      return fabs(s.target - setPoint) / s.rampRate + s.holdMs / 1000;
+    case PROFILE_HOLD:
+      return (s.holdMs - min(s.holdMs, (uint32_t) (millis() - holdStartMillis))) / 1000;
+    default:
+      return s.holdMs / 1000;
+  }
+}
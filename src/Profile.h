@@ -0,0 +1,56 @@
+// Mash profile run on the controller, so a schedule of rests carries on
+// without the cloud. Each step ramps the set point to its target at a
+// given rate, or steps it there at once, waits for the temperature to come
+// within a band of the target and then holds for the step's time. After
+// the last step the set point stays at its target.
+//
+// Stored as JSON:
+//
+//   {"name": "Single infusion",
+//    "steps": [{"name": "Mash", "target": 66, "ramp": 1, "hold": 60, "within": 0.5},
+//              {"name": "Mash out", "target": 76, "ramp": 1, "hold": 10}]}
+//
+// with ramp in C/min, 0 or absent for a step change, hold in minutes and
+// within in C, PROFILE_WITHIN if absent.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <json/FirebaseJson.h>
+
+#define PROFILE_MAX_STEPS 10
+#define PROFILE_NAME_LEN 12
+#define PROFILE_WITHIN 0.5
+
+typedef enum { PROFILE_IDLE, PROFILE_RAMP, PROFILE_WAIT, PROFILE_HOLD, PROFILE_DONE } ProfileState;
+
+class Profile {
+public:
+  Profile();
+  bool load(const char *path);
+  void start(double setPoint);
+  void stop() { profileState = PROFILE_IDLE; }
+  double update(double temperature);
+  bool running() const { return profileState != PROFILE_IDLE && profileState != PROFILE_DONE; }
+  ProfileState state() const { return profileState; }
+  uint8_t step() const { return current; }
+  uint8_t steps() const { return nSteps; }
+  const char *stepName() const { return nSteps ? stepList[current].name : ""; }
+  int32_t remaining() const;
+private:
+  struct Step {
+    char name[PROFILE_NAME_LEN];
+    float target;
+    float rampRate;  // C/s, 0 for a step change
+    uint32_t holdMs;
+    float within;
+  };
+  void enter(uint8_t step);
+
+  Step stepList[PROFILE_MAX_STEPS];
+  uint8_t nSteps;
+  uint8_t current;
+  ProfileState profileState;
+  double setPoint;
+  uint32_t lastMillis;
+  uint32_t holdStartMillis;
+};
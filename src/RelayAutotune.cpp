@@ -0,0 +1,68 @@
+#include "RelayAutotune.h"
+
+RelayAutotune::RelayAutotune(double outputMax)
+  : outputMax(outputMax), setPoint(0), tuneState(AUTOTUNE_IDLE), relayOn(false),
+    startMillis(0), onMillis(0), offMillis(0), onSeen(false), high(0), low(0), nCycles(0),
+    periodSum(0), amplitudeSum(0), onSum(0), ku(0), pu(0) {}
+
+// Start oscillating around setPoint
+
+void RelayAutotune::begin(double setPoint) {
+  this->setPoint = setPoint;
+  tuneState = AUTOTUNE_RUNNING;
+  relayOn = true;
+  startMillis = millis();
+  onSeen = false;
+  nCycles = 0;
+  periodSum = amplitudeSum = onSum = 0;
+}
+
+void RelayAutotune::cancel() {
+  if (tuneState == AUTOTUNE_RUNNING) tuneState = AUTOTUNE_IDLE;
+}
+
+// Take the current temperature and return the output to apply. Each cycle
+// runs from one switch-on of the relay to the next.
+
+double RelayAutotune::update(double input) {
+  if (tuneState != AUTOTUNE_RUNNING) return 0;
+  uint32_t now = millis();
+  if (now - startMillis > AUTOTUNE_TIMEOUT) {
+    tuneState = AUTOTUNE_FAILED;
+    return 0;
+  }
+
+  if (relayOn && input > setPoint + AUTOTUNE_HYSTERESIS) {
+    relayOn = false;
+    offMillis = now;
+  } else if (!relayOn && input < setPoint - AUTOTUNE_HYSTERESIS) {
+    relayOn = true;
+    if (onSeen) {
+      double amplitude = (high - low) / 2;
+      if (nCycles > 0) {
+        periodSum += (now - onMillis) / 1000.0;
+        onSum += (offMillis - onMillis) / 1000.0;
+        amplitudeSum += amplitude;
+      }
+      nCycles++;
+    }
+    onSeen = true;
+    onMillis = now;
+    high = low = input;
+  }
+  high = max(high, input);
+  low = min(low, input);
+
+  if (nCycles > AUTOTUNE_CYCLES) {
+    double a = amplitudeSum / AUTOTUNE_CYCLES;
+    pu = periodSum / AUTOTUNE_CYCLES;
+    if (a <= AUTOTUNE_HYSTERESIS) {
+      tuneState = AUTOTUNE_FAILED;
+      return 0;
+    }
+    ku = 4 * (outputMax / 2) / (PI * sqrt(a * a - AUTOTUNE_HYSTERESIS * AUTOTUNE_HYSTERESIS));
+    tuneState = AUTOTUNE_DONE;
+    return 0;
+  }
+  return relayOn ? outputMax : 0;
+}
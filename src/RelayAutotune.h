@@ -0,0 +1,46 @@
+// Relay feedback experiment (Astrom-Hagglund) for tuning the temperature
+// PID. The heater is switched fully on below the set point and off above
+// it, with some hysteresis, which makes the temperature oscillate at the
+// process's ultimate period Pu. With relay amplitude d (half the output
+// range) and oscillation amplitude a, the ultimate gain is
+//
+//   Ku = 4 d / (pi sqrt(a^2 - h^2))
+//
+// where h is the hysteresis. Pu and a are averaged over AUTOTUNE_CYCLES
+// cycles after the first, which still carries the initial heat-up. Gains
+// follow the classic Ziegler-Nichols rules.
+
+#include <Arduino.h>
+
+#define AUTOTUNE_CYCLES 3
+#define AUTOTUNE_HYSTERESIS 0.1
+#define AUTOTUNE_TIMEOUT (6 * 3600 * 1000UL)
+
+typedef enum { AUTOTUNE_IDLE, AUTOTUNE_RUNNING, AUTOTUNE_DONE, AUTOTUNE_FAILED } AutotuneState;
+
+class RelayAutotune {
+public:
+  RelayAutotune(double outputMax);
+  void begin(double setPoint);
+  double update(double input);
+  void cancel();
+  AutotuneState state() const { return tuneState; }
+  double target() const { return setPoint; }
+  uint8_t cycles() const { return nCycles; }
+  double ultimateGain() const { return ku; }
+  double ultimatePeriod() const { return pu; }
+  double kp() const { return 0.6 * ku; }
+  double ki() const { return 1.2 * ku / pu; }
+  double kd() const { return 0.075 * ku * pu; }
+  double averageOutput() const { return outputMax * onSum / periodSum; }
+private:
+  double outputMax, setPoint;
+  AutotuneState tuneState;
+  bool relayOn;
+  uint32_t startMillis, onMillis, offMillis;
+  bool onSeen;
+  double high, low;
+  uint8_t nCycles;
+  double periodSum, amplitudeSum, onSum;
+  double ku, pu;
+};
@@ -0,0 +1,26 @@
+#include "RtdConverter.h"
+
+RtdConverter::RtdConverter() {
+  memset(table, 0, sizeof(table));
+}
+
+// Tabulate the library's conversion for a probe of rNominal ohms at 0 C
+// read against a reference of rRef ohms. Nodes past the end of the probe's
+// curve repeat the last valid one.
+
+void RtdConverter::begin(Adafruit_MAX31865 &thermo, float rNominal, float rRef) {
+  for (uint16_t i = 0; i < RTD_TABLE_SIZE; i++) {
+    float t = thermo.calculateTemperature(i << RTD_TABLE_SHIFT, rNominal, rRef);
+    table[i] = (isnan(t) && i) ? table[i - 1] : lroundf(t * 100);
+  }
+}
+
+// Temperature in 0.01 C for a raw 15-bit RTD code
+
+int32_t RtdConverter::centiDegrees(uint16_t code) const {
+  code &= 0x7FFF;
+  uint16_t i = code >> RTD_TABLE_SHIFT;
+  int32_t frac = code & ((1 << RTD_TABLE_SHIFT) - 1);
+  int32_t span = table[i + 1] - table[i];
+  return table[i] + (span * frac + (1 << (RTD_TABLE_SHIFT - 1))) / (1 << RTD_TABLE_SHIFT);
+}
@@ -0,0 +1,122 @@
+#include "RtdSensor.h"
+#include "SpiBus.h"
+
+// Registers and configuration bits not exposed by the library
+
+#define REG_CONFIG 0x00
+#define REG_RTD_MSB 0x01
+#define CONFIG_1SHOT 0x20
+#define RTD_FAULT_BIT 0x01
+
+RtdSensor::RtdSensor(Adafruit_MAX31865 &thermo, uint8_t cs)
+  : thermo(thermo), cs(cs), spiDevice(-1), filter(RTD_FILTER_50HZ),
+    appliedFilter(RTD_FILTER_50HZ), periodMs(0), state(RTD_IDLE), stepMillis(0),
+    startMillis(0), code(0), faultBits(0), fresh(false) {}
+
+// Configure the converter and start sampling every periodMs, the first
+// conversion after delayMs. spiDevice is the converter's SpiBus handle.
+
+void RtdSensor::begin(int8_t spiDevice, max31865_numwires_t wires, RtdFilter filter,
+                      uint32_t periodMs, uint32_t delayMs) {
+  this->spiDevice = spiDevice;
+  this->filter = appliedFilter = filter;
+  if (SpiBus::acquire(spiDevice)) {
+    thermo.begin(wires);
+    thermo.enable50Hz(filter == RTD_FILTER_50HZ);
+    SpiBus::release(spiDevice);
+  }
+  setPeriod(periodMs);
+  state = RTD_IDLE;
+  stepMillis = millis() + delayMs;
+}
+
+// Time between conversion starts, no shorter than a conversion
+
+void RtdSensor::setPeriod(uint32_t periodMs) {
+  this->periodMs = max(periodMs, minPeriod());
+}
+
+uint32_t RtdSensor::minPeriod() const {
+  return RTD_BIAS_TIME + RTD_CONVERSION_TIME_50HZ;
+}
+
+// Do the step that is due, if any. Returns the time in ms until the next
+// step, which is when poll() should be called again.
+
+uint32_t RtdSensor::poll() {
+  uint32_t now = millis();
+  if ((int32_t)(now - stepMillis) < 0) return stepMillis - now;
+  if (!SpiBus::acquire(spiDevice)) return 1;
+
+  if (state == RTD_IDLE) {
+    startMillis = now;
+    start();
+    state = RTD_BIASING;
+    stepMillis = now + RTD_BIAS_TIME;
+  } else if (state == RTD_BIASING) {
+    uint8_t config;
+    readRegisters(REG_CONFIG, &config, 1);
+    writeRegister8(REG_CONFIG, config | CONFIG_1SHOT);
+    state = RTD_CONVERTING;
+    stepMillis = now + (appliedFilter == RTD_FILTER_50HZ ? RTD_CONVERSION_TIME_50HZ
+                                                         : RTD_CONVERSION_TIME_60HZ);
+  } else {
+    collect();
+    state = RTD_IDLE;
+
+    // Keep the sample rate unless polling fell behind it
+
+    stepMillis = startMillis + periodMs;
+    if ((int32_t)(now - stepMillis) > 0) stepMillis = now;
+  }
+  SpiBus::release(spiDevice);
+  return stepMillis - now;
+}
+
+// Latest raw 15-bit RTD code, ratio of the probe to the reference resistor
+
+uint16_t RtdSensor::read() {
+  fresh = false;
+  return code;
+}
+
+// Clear the fault of the last reading, apply a new filter setting and bias
+// the probe
+
+void RtdSensor::start() {
+  if (faultBits) thermo.clearFault();
+  if (filter != appliedFilter) {
+    thermo.enable50Hz(filter == RTD_FILTER_50HZ);
+    appliedFilter = filter;
+  }
+  thermo.enableBias(true);
+}
+
+// Read the conversion result, and the fault status if it flags one, then
+// remove the bias
+
+void RtdSensor::collect() {
+  uint8_t buf[2];
+  readRegisters(REG_RTD_MSB, buf, 2);
+  code = (buf[0] << 8 | buf[1]) >> 1;
+  faultBits = (buf[1] & RTD_FAULT_BIT) ? thermo.readFault() : 0;
+  thermo.enableBias(false);
+  fresh = true;
+}
+
+// Register access for what the library keeps private. The bus is already
+// set up for the converter by SpiBus.
+
+void RtdSensor::readRegisters(uint8_t addr, uint8_t *buf, uint8_t n) {
+  digitalWrite(cs, LOW);
+  SPI.transfer(addr & 0x7F);
+  for (uint8_t i = 0; i < n; i++) buf[i] = SPI.transfer(0xFF);
+  digitalWrite(cs, HIGH);
+}
+
+void RtdSensor::writeRegister8(uint8_t addr, uint8_t value) {
+  digitalWrite(cs, LOW);
+  SPI.transfer(addr | 0x80);
+  SPI.transfer(value);
+  digitalWrite(cs, HIGH);
+}
@@ -0,0 +1,55 @@
+// Non-blocking reads of the MAX31865 RTD converter. The library's
+// temperature() biases the probe, waits for it to settle and for a one-shot
+// conversion, about 75 ms of delay() per reading. Here the same steps are a
+// state machine: poll() does the step that is due, a few bytes on the bus,
+// and returns how long until the next one. DRDY isn't wired, so the
+// conversion is collected after its worst-case time.
+//
+// Conversions start every sample period. The bias is only on for the
+// conversion, which keeps self-heating of the probe down at low sample
+// rates. Converters sharing the bus can be given different start delays,
+// so their steps don't all fall due together.
+
+#include <Arduino.h>
+#include <Adafruit_MAX31865.h>
+
+// Bias settling time for the filter capacitor on the breakout, and
+// worst-case one-shot conversion times per notch filter
+
+#define RTD_BIAS_TIME 10
+#define RTD_CONVERSION_TIME_50HZ 63
+#define RTD_CONVERSION_TIME_60HZ 53
+
+typedef enum { RTD_FILTER_50HZ, RTD_FILTER_60HZ } RtdFilter;
+
+class RtdSensor {
+public:
+  RtdSensor(Adafruit_MAX31865 &thermo, uint8_t cs);
+  void begin(int8_t spiDevice, max31865_numwires_t wires, RtdFilter filter, uint32_t periodMs,
+             uint32_t delayMs = 0);
+  void setFilter(RtdFilter filter) { this->filter = filter; }
+  void setPeriod(uint32_t periodMs);
+  uint32_t poll();
+  bool available() const { return fresh; }
+  uint16_t read();
+  uint8_t fault() const { return faultBits; }
+  uint32_t minPeriod() const;
+private:
+  enum State { RTD_IDLE, RTD_BIASING, RTD_CONVERTING };
+  void readRegisters(uint8_t addr, uint8_t *buf, uint8_t n);
+  void writeRegister8(uint8_t addr, uint8_t value);
+  void start();
+  void collect();
+
+  Adafruit_MAX31865 &thermo;
+  uint8_t cs;
+  int8_t spiDevice;
+  RtdFilter filter, appliedFilter;
+  uint32_t periodMs;
+  State state;
+  uint32_t stepMillis;  // when the next step is due
+  uint32_t startMillis; // when the current sample period started
+  uint16_t code;
+  uint8_t faultBits;
+  bool fresh;
+};
@@ -0,0 +1,106 @@
+#include "Scheduler.h"
+
+Scheduler::Task Scheduler::tasks[SCHEDULER_MAX_TASKS];
+uint8_t Scheduler::nTasks = 0;
+uint32_t Scheduler::statsMillis = 0;
+
+// True if deadline has been reached at now, allowing for wraparound as long
+// as the two are less than 2^31 ms apart
+
+static bool due(uint32_t now, uint32_t deadline) {
+  return (int32_t)(now - deadline) >= 0;
+}
+
+// Add a task that first runs after delayMs and then every periodMs, or only
+// once if periodMs is 0. Returns the handle used for the other calls, or -1
+// if there is no room.
+
+int8_t Scheduler::addTask(const char *name, SchedulerTask task, void *ctx, uint32_t periodMs,
+                          uint8_t priority, uint32_t delayMs) {
+  if (nTasks >= SCHEDULER_MAX_TASKS) return -1;
+  Task &t = tasks[nTasks];
+  t.name = name;
+  t.task = task;
+  t.ctx = ctx;
+  t.periodMs = periodMs;
+  t.deadline = millis() + delayMs;
+  t.priority = priority;
+  t.armed = true;
+  t.runs = t.overruns = 0;
+  t.totalUs = t.maxUs = t.maxLateMs = 0;
+  return nTasks++;
+}
+
+// Make a task due again after delayMs, e.g. to rearm a one-shot task or to
+// restart a periodic one from now
+
+void Scheduler::schedule(int8_t task, uint32_t delayMs) {
+  if (task < 0 || task >= nTasks) return;
+  tasks[task].deadline = millis() + delayMs;
+  tasks[task].armed = true;
+}
+
+// Run the tasks that are due, most urgent first, each at most once
+
+void Scheduler::run() {
+  bool ran[SCHEDULER_MAX_TASKS] = { false };
+  while (true) {
+    uint32_t now = millis();
+    int8_t next = -1;
+    for (uint8_t i = 0; i < nTasks; i++) {
+      Task &t = tasks[i];
+      if (!t.armed || ran[i] || !due(now, t.deadline)) continue;
+      if (next < 0 || t.priority < tasks[next].priority) next = i;
+    }
+    if (next < 0) return;
+
+    Task &t = tasks[next];
+    ran[next] = true;
+    uint32_t late = now - t.deadline;
+    if (late > t.maxLateMs) t.maxLateMs = late;
+
+    // Periodic tasks keep their phase; if a whole period has been missed
+    // they restart from now instead of running to catch up
+
+    if (t.periodMs) {
+      t.deadline += t.periodMs;
+      if (due(now, t.deadline)) {
+        t.overruns++;
+        t.deadline = now + t.periodMs;
+      }
+    } else {
+      t.armed = false;
+    }
+
+    uint32_t start = micros();
+    t.task(t.ctx);
+    uint32_t elapsed = micros() - start;
+    t.runs++;
+    t.totalUs += elapsed;
+    if (elapsed > t.maxUs) t.maxUs = elapsed;
+  }
+}
+
+// Table of per-task statistics since the last reset, with the share of time
+// each task took
+
+void Scheduler::printStats(Print &out) {
+  uint32_t spanMs = millis() - statsMillis;
+  out.printf("%-10s %3s %8s %8s %8s %8s %6s %6s\n", "task", "pri", "runs", "avg us", "max us",
+             "late ms", "overrn", "load");
+  for (uint8_t i = 0; i < nTasks; i++) {
+    const Task &t = tasks[i];
+    out.printf("%-10s %3u %8u %8u %8u %8u %6u %5.1f%%\n", t.name, t.priority, t.runs,
+               t.runs ? t.totalUs / t.runs : 0, t.maxUs, t.maxLateMs, t.overruns,
+               spanMs ? t.totalUs / 10.0 / spanMs : 0.0);
+  }
+}
+
+void Scheduler::resetStats() {
+  for (uint8_t i = 0; i < nTasks; i++) {
+    Task &t = tasks[i];
+    t.runs = t.overruns = 0;
+    t.totalUs = t.maxUs = t.maxLateMs = 0;
+  }
+  statsMillis = millis();
+}
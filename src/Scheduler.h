@@ -0,0 +1,36 @@
+// Cooperative scheduler for the work done from loop(). Tasks are periodic or
+// one-shot and run in priority order when due, 0 being the most urgent. Each
+// task keeps statistics of its run time and of overruns, i.e. periods it
+// missed because it started a whole period late. Deadlines are compared by
+// difference, so they survive millis() wrapping around.
+
+#include <Arduino.h>
+
+#define SCHEDULER_MAX_TASKS 10
+
+typedef void (*SchedulerTask)(void *ctx);
+
+class Scheduler {
+public:
+  static int8_t addTask(const char *name, SchedulerTask task, void *ctx, uint32_t periodMs,
+                        uint8_t priority, uint32_t delayMs = 0);
+  static void schedule(int8_t task, uint32_t delayMs);
+  static void run();
+  static void printStats(Print &out);
+  static void resetStats();
+private:
+  struct Task {
+    const char *name;
+    SchedulerTask task;
+    void *ctx;
+    uint32_t periodMs;  // 0 for one-shot tasks
+    uint32_t deadline;
+    uint8_t priority;
+    bool armed;
+    uint32_t runs, overruns;
+    uint32_t totalUs, maxUs, maxLateMs;
+  };
+  static Task tasks[SCHEDULER_MAX_TASKS];
+  static uint8_t nTasks;
+  static uint32_t statsMillis;
+};
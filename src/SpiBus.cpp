@@ -0,0 +1,45 @@
+#include "SpiBus.h"
+
+SpiBus::Device SpiBus::devices[SPI_BUS_MAX_DEVICES];
+uint8_t SpiBus::nDevices = 0;
+int8_t SpiBus::holder = -1;
+uint8_t SpiBus::depth = 0;
+
+// Register a device and park its chip select high. Returns the handle used
+// for the other calls, or -1 if there is no room.
+
+int8_t SpiBus::addDevice(uint8_t cs, uint32_t frequency, uint8_t dataMode) {
+  if (nDevices >= SPI_BUS_MAX_DEVICES) return -1;
+  devices[nDevices].cs = cs;
+  devices[nDevices].settings = SPISettings(frequency, MSBFIRST, dataMode);
+  pinMode(cs, OUTPUT);
+  digitalWrite(cs, HIGH);
+  return nDevices++;
+}
+
+// Start a transaction with the device's settings, or join the one it is
+// already in. Returns false, without touching the bus, if the device isn't
+// registered or another device holds the bus.
+
+bool SpiBus::acquire(int8_t device) {
+  if (device < 0 || device >= nDevices) return false;
+  if (holder == device) {
+    depth++;
+    return true;
+  }
+  if (holder >= 0) return false;
+  holder = device;
+  depth = 1;
+  SPI.beginTransaction(devices[device].settings);
+  return true;
+}
+
+// End the device's transaction once every acquire() it made is released.
+// A device that doesn't hold the bus is ignored.
+
+void SpiBus::release(int8_t device) {
+  if (device != holder || device < 0) return;
+  if (--depth) return;
+  holder = -1;
+  SPI.endTransaction();
+}
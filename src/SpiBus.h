@@ -0,0 +1,36 @@
+// Per-device settings for the SPI bus shared by the display, touch
+// controller and RTD converter. Each device is registered with its own
+// clock and mode, which are applied whenever it takes the bus, so a fast
+// device never leaves the bus at a clock a slower one can't handle.
+//
+// Sharing is cooperative: everything that uses the bus runs from loop(),
+// one transaction at a time, and nothing touches it from an interrupt, so
+// there is nothing to queue. The bus still keeps track of which device
+// holds it. A device may acquire it again while it holds it, e.g. from a
+// helper, and it is freed on the matching release(). acquire() fails for
+// any other device until then, and the caller then leaves its chip select
+// alone and tries again later, so two devices are never selected at once
+// even if the contract is broken. The display driver isn't registered; it
+// applies its own settings at the start of every operation. Work on the bus
+// from an interrupt would need a lock.
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#define SPI_BUS_MAX_DEVICES 4
+
+class SpiBus {
+public:
+  static int8_t addDevice(uint8_t cs, uint32_t frequency, uint8_t dataMode);
+  static bool acquire(int8_t device);
+  static void release(int8_t device);
+private:
+  struct Device {
+    uint8_t cs;
+    SPISettings settings;
+  };
+  static Device devices[SPI_BUS_MAX_DEVICES];
+  static uint8_t nDevices;
+  static int8_t holder;  // device holding the bus, -1 if free
+  static uint8_t depth;  // acquires by the holder not yet released
+};
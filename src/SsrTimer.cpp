@@ -0,0 +1,313 @@
+#include "SsrTimer.h"
+
+// Timer1 counts at 80 MHz / 256 = 312.5 kHz. Its 23-bit counter then covers
+// 26.8 s, enough for a whole cycle in one interval.
+
+#define TICKS(ms) ((ms) * 625 / 2)
+
+// One mains half-cycle, in timer ticks
+
+#define HALF_CYCLE_TICKS (312500 / (2 * SSR_MAINS_HZ))
+
+SsrTimer::Channel SsrTimer::outputs[SSR_MAX_CHANNELS];
+uint8_t SsrTimer::nChannels = 0;
+uint32_t SsrTimer::cycleMs = 0;
+uint16_t SsrTimer::budgetDeciAmps = 0;
+uint8_t SsrTimer::maxPriority = 0;
+uint16_t SsrTimer::slotMs = SSR_SLOT_MS;
+uint16_t SsrTimer::nSlots = 0;
+uint8_t SsrTimer::plan[SSR_MAX_SLOTS];
+uint16_t SsrTimer::cycleHalfCycles = 1;
+uint16_t SsrTimer::halfCycle = 0;
+uint16_t SsrTimer::fires = 0;
+volatile SsrMode SsrTimer::mode = SSR_MODE_WINDOW;
+volatile uint32_t SsrTimer::positionMs = 0;
+
+// Add an output, off until an on time is set. ledPin, if not -1, mirrors
+// the output on an active-low LED, set by updateLeds() from loop() rather
+// than the interrupt: on a D1 mini the built-in LED is GPIO2, the display's
+// D/C line, which must not change in the middle of an SPI transfer. amps is
+// the load's current, counted against the budget. priority is capped at
+// SSR_MAX_CHANNELS - 1, which is enough to tell all the channels apart.
+// Channels are added before begin(). Returns the channel, or -1 if there
+// are too many.
+
+int8_t SsrTimer::addChannel(uint8_t pin, int8_t ledPin, float amps, uint8_t priority) {
+  if (nChannels >= SSR_MAX_CHANNELS) return -1;
+  Channel &c = outputs[nChannels];
+  c.pin = pin;
+  c.ledPin = ledPin;
+  c.phaseMs = 0;
+  c.deciAmps = amps * 10 + 0.5;
+  c.priority = min(priority, (uint8_t) (SSR_MAX_CHANNELS - 1));
+  maxPriority = max(maxPriority, c.priority);
+  c.accumulator = 0;
+  c.nextOnMs = 0;
+  c.onMs = 0;
+  c.fired = 0;
+  c.firedAt = 0;
+  c.cut = false;
+  c.level = LOW;
+  pinMode(pin, OUTPUT);
+  if (ledPin >= 0) pinMode(ledPin, OUTPUT);
+  setOutput(c, LOW);
+  return nChannels++;
+}
+
+// Start cycling the outputs, with their cycles spread evenly over cycleMs
+
+void SsrTimer::begin(uint32_t cycleMs) {
+  SsrTimer::cycleMs = cycleMs;
+  for (uint8_t i = 0; i < nChannels; i++) {
+    outputs[i].phaseMs = cycleMs * i / nChannels;
+  }
+  timer1_attachInterrupt(onTimer);
+  timer1_enable(TIM_DIV256, TIM_EDGE, TIM_SINGLE);
+  restart();
+}
+
+// Limit the total current of the outputs that are on, 0 for no limit.
+// Restarts the cycle.
+
+void SsrTimer::setBudget(float amps) {
+  noInterrupts();
+  budgetDeciAmps = amps * 10 + 0.5;
+  if (cycleMs) restart();
+  interrupts();
+}
+
+// On time for the following cycles of a channel, clamped to the cycle
+
+void SsrTimer::setOnTime(uint8_t channel, uint32_t onMs) {
+  outputs[channel].nextOnMs = min(onMs, cycleMs);
+}
+
+// On time granted to the channel: of its cycle in progress in window mode,
+// over the last cycle in sigma-delta mode
+
+uint32_t SsrTimer::onTime(uint8_t channel) {
+  return outputs[channel].cut ? 0 : outputs[channel].onMs;
+}
+
+// Switch a channel off at once and keep it off until its next cycle starts
+// with a new on time. The sigma-delta backlog is dropped, so nothing owed
+// fires later. The interrupts keep their schedule, so the cycle doesn't
+// shift.
+
+void SsrTimer::cutOff(uint8_t channel) {
+  noInterrupts();
+  outputs[channel].nextOnMs = 0;
+  outputs[channel].accumulator = 0;
+  outputs[channel].fired = 0;
+  outputs[channel].cut = true;
+  setOutput(outputs[channel], LOW);
+  interrupts();
+}
+
+// Change modulation, restarting the cycle
+
+void SsrTimer::setMode(SsrMode mode) {
+  if (mode == SsrTimer::mode) return;
+  noInterrupts();
+  SsrTimer::mode = mode;
+  restart();
+  interrupts();
+}
+
+// Start the cycle over at the next interrupt. The sigma-delta accumulators
+// start from the channel phases, so the channels don't fire together either.
+// The slots stretch so the whole cycle fits the plan, the last one shorter
+// if the cycle isn't a multiple of them.
+
+void SsrTimer::restart() {
+  positionMs = 0;
+  slotMs = max((uint32_t) SSR_SLOT_MS, (cycleMs + SSR_MAX_SLOTS - 1) / SSR_MAX_SLOTS);
+  nSlots = (cycleMs + slotMs - 1) / slotMs;
+  cycleHalfCycles = max(cycleMs * 2 * SSR_MAINS_HZ / 1000, (uint32_t) 1);
+  halfCycle = 0;
+  for (uint8_t i = 0; i < nChannels; i++) {
+    outputs[i].accumulator = outputs[i].phaseMs;
+    outputs[i].fired = 0;
+  }
+  timer1_write(TICKS(1));
+}
+
+// Mirror the outputs on their LEDs, from loop()
+
+void SsrTimer::updateLeds() {
+  for (uint8_t i = 0; i < nChannels; i++) {
+    if (outputs[i].ledPin >= 0) digitalWrite(outputs[i].ledPin, !outputs[i].level);
+  }
+}
+
+void IRAM_ATTR SsrTimer::setOutput(Channel &channel, uint8_t level) {
+  digitalWrite(channel.pin, level);
+  channel.level = level;
+}
+
+// Set all outputs, a bit per channel, switching off before switching on so
+// a handover between channels never has both on
+
+void IRAM_ATTR SsrTimer::setOutputs(uint8_t on) {
+  for (uint8_t i = 0; i < nChannels; i++) {
+    if (!(on >> i & 1)) setOutput(outputs[i], LOW);
+  }
+  for (uint8_t i = 0; i < nChannels; i++) {
+    if (on >> i & 1) setOutput(outputs[i], HIGH);
+  }
+}
+
+// In window mode runs whenever a channel starts a cycle or ends its on time,
+// or under a budget at the slots where the plan changes; in sigma-delta mode
+// every half-cycle
+
+void IRAM_ATTR SsrTimer::onTimer() {
+  if (mode == SSR_MODE_SIGMA_DELTA) {
+    onSigmaDelta();
+    return;
+  }
+  if (budgetDeciAmps) {
+    onSlot();
+    return;
+  }
+
+  // Set each channel for where it is in its own cycle, and find the
+  // nearest edge of any of them
+
+  uint32_t nextMs = cycleMs;
+  for (uint8_t i = 0; i < nChannels; i++) {
+    Channel &c = outputs[i];
+    uint32_t t = (positionMs + cycleMs - c.phaseMs) % cycleMs;
+    if (t == 0) {
+      c.onMs = c.nextOnMs;
+      c.cut = false;
+    }
+    bool on = t < c.onMs && !c.cut;
+    setOutput(c, on ? HIGH : LOW);
+    uint32_t untilMs = on && c.onMs < cycleMs ? c.onMs - t : cycleMs - t;
+    if (untilMs < nextMs) nextMs = untilMs;
+  }
+  positionMs = (positionMs + nextMs) % cycleMs;
+  timer1_write(TICKS(nextMs));
+}
+
+// Fire the channels whose accumulators overflow. Under a budget they go in
+// order of priority, then of how much on time they are owed, then of how long
+// ago they last fired, and those that don't fit wait for a later half-cycle, owing at
+// most one cycle's worth.
+// After each cycle's worth of half-cycles the on time granted is published.
+
+void IRAM_ATTR SsrTimer::onSigmaDelta() {
+  uint8_t order[SSR_MAX_CHANNELS];
+  for (uint8_t i = 0; i < nChannels; i++) {
+    Channel &c = outputs[i];
+    c.accumulator += c.nextOnMs;
+    uint8_t j = i;
+    for (; j > 0; j--) {
+      Channel &o = outputs[order[j - 1]];
+      if (o.priority < c.priority ||
+          (o.priority == c.priority && (o.accumulator > c.accumulator ||
+           (o.accumulator == c.accumulator && (int16_t) (o.firedAt - c.firedAt) <= 0)))) break;
+      order[j] = order[j - 1];
+    }
+    order[j] = i;
+  }
+  uint16_t load = 0;
+  uint8_t on = 0;
+  for (uint8_t k = 0; k < nChannels; k++) {
+    Channel &c = outputs[order[k]];
+    if (c.accumulator >= cycleMs && (!budgetDeciAmps || load + c.deciAmps <= budgetDeciAmps)) {
+      c.accumulator -= cycleMs;
+      c.fired++;
+      c.firedAt = ++fires;
+      load += c.deciAmps;
+      on |= 1 << order[k];
+    } else if (c.accumulator >= 2 * cycleMs) {
+      c.accumulator = 2 * cycleMs - 1;
+    }
+  }
+  setOutputs(on);
+  if (++halfCycle >= cycleHalfCycles) {
+    for (uint8_t i = 0; i < nChannels; i++) {
+      Channel &c = outputs[i];
+      c.onMs = (uint32_t) c.fired * cycleMs / cycleHalfCycles;
+      c.fired = 0;
+      c.cut = false;
+    }
+    halfCycle = 0;
+  }
+  timer1_write(HALF_CYCLE_TICKS);
+}
+
+// Set the outputs for the slot at positionMs, planning the cycle at its
+// start, and wait for the next slot that differs
+
+void IRAM_ATTR SsrTimer::onSlot() {
+  uint16_t slot = positionMs / slotMs;
+  if (slot == 0) planCycle();
+  uint8_t on = plan[slot];
+  for (uint8_t i = 0; i < nChannels; i++) {
+    if (outputs[i].cut) on &= ~(1 << i);
+  }
+  setOutputs(on);
+  uint16_t next = slot + 1;
+  while (next < nSlots && plan[next] == plan[slot]) next++;
+  uint32_t endMs = slotEnd(next - 1);
+  timer1_write(TICKS(endMs - positionMs));
+  positionMs = endMs < cycleMs ? endMs : 0;
+}
+
+// Pack the on times of the cycle starting now into slots. A slot a channel
+// can't have now stays out of reach, as the load only grows, so each
+// channel's cursor goes round the cycle at most once.
+
+void IRAM_ATTR SsrTimer::planCycle() {
+  uint16_t slots = nSlots;
+  uint16_t wanted[SSR_MAX_CHANNELS], cursor[SSR_MAX_CHANNELS], scanned[SSR_MAX_CHANNELS];
+  memset(plan, 0, slots);
+  for (uint8_t i = 0; i < nChannels; i++) {
+    Channel &c = outputs[i];
+    c.cut = false;
+    wanted[i] = (c.nextOnMs + slotMs / 2) / slotMs;
+    cursor[i] = c.phaseMs / slotMs;
+    scanned[i] = 0;
+    c.onMs = 0;
+  }
+  for (uint16_t priority = 0; priority <= maxPriority; priority++) {
+    bool granted = true;
+    while (granted) {
+      granted = false;
+      for (uint8_t i = 0; i < nChannels; i++) {
+        Channel &c = outputs[i];
+        if (c.priority != priority || !wanted[i]) continue;
+        while (scanned[i] < slots) {
+          uint16_t slot = cursor[i];
+          cursor[i] = (slot + 1) % slots;
+          scanned[i]++;
+          if (slotLoad(slot) + c.deciAmps <= budgetDeciAmps) {
+            plan[slot] |= 1 << i;
+            wanted[i]--;
+            c.onMs += slotEnd(slot) - slot * slotMs;
+            granted = true;
+            break;
+          }
+        }
+        if (scanned[i] >= slots) wanted[i] = 0;
+      }
+    }
+  }
+}
+
+uint16_t IRAM_ATTR SsrTimer::slotLoad(uint16_t slot) {
+  uint16_t load = 0;
+  for (uint8_t i = 0; i < nChannels; i++) {
+    if (plan[slot] >> i & 1) load += outputs[i].deciAmps;
+  }
+  return load;
+}
+
+// End of a slot within the cycle
+
+uint32_t IRAM_ATTR SsrTimer::slotEnd(uint16_t slot) {
+  return min((uint32_t) (slot + 1) * slotMs, cycleMs);
+}
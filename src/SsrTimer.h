@@ -0,0 +1,86 @@
+// Time-proportioning outputs for the SSRs, switched from the timer1
+// interrupt so the edges keep their timing whatever loop() is busy with.
+// loop() only publishes the on time per cycle of each channel, which takes
+// effect at the start of the channel's next cycle.
+//
+// In window mode each SSR is on for the first part of its cycle. The cycles
+// of the channels are staggered evenly over the cycle time, so with low
+// duties the elements take turns rather than all switching on together. In
+// sigma-delta mode the same share of on time is spread over the mains
+// half-cycles: an accumulator per channel adds the duty every half-cycle,
+// and the SSR conducts for the half-cycles where it overflows. The timer
+// isn't locked to the mains, so a zero-crossing SSR may occasionally shift
+// a half-cycle.
+//
+// With a current budget, e.g. for elements sharing one breaker, the outputs
+// on at any time never draw more than the budget. In window mode the cycle
+// is then split into slots of SSR_SLOT_MS, longer if the cycle needs more
+// than SSR_MAX_SLOTS of them, and at the start of each cycle the requested
+// on times are packed into slots where the budget allows, each channel from
+// its own phase onwards so its on time stays in one piece where it can.
+// Channels are served in order of priority, 0 first, and channels of equal
+// priority take slots in turn, so they share what is left evenly. In
+// sigma-delta mode a half-cycle that would exceed the budget is held back
+// and fired later, the same order deciding which channels go first.
+//
+// Either way onTime() returns what was granted: in window mode the on time
+// of the cycle in progress, in sigma-delta mode the half-cycles fired over
+// the last cycle's worth of them.
+
+#include <Arduino.h>
+
+#define SSR_MAINS_HZ 50
+#define SSR_MAX_CHANNELS 4
+#define SSR_SLOT_MS 50
+#define SSR_MAX_SLOTS 200
+
+typedef enum { SSR_MODE_WINDOW=0, SSR_MODE_SIGMA_DELTA=1 } SsrMode;
+
+class SsrTimer {
+public:
+  static int8_t addChannel(uint8_t pin, int8_t ledPin, float amps = 0, uint8_t priority = 0);
+  static void begin(uint32_t cycleMs);
+  static void setBudget(float amps);
+  static uint8_t channels() { return nChannels; }
+  static void setOnTime(uint8_t channel, uint32_t onMs);
+  static uint32_t onTime(uint8_t channel);
+  static void cutOff(uint8_t channel);
+  static void updateLeds();
+  static void setMode(SsrMode mode);
+  static SsrMode getMode() { return mode; }
+private:
+  struct Channel {
+    uint8_t pin;
+    int8_t ledPin;
+    uint32_t phaseMs;               // start of its cycle within the cycle time
+    uint16_t deciAmps;
+    uint8_t priority;
+    volatile uint32_t accumulator;  // sigma-delta error, on time per cycle
+    volatile uint32_t nextOnMs;     // on time for the next cycle
+    volatile uint32_t onMs;         // on time granted, as onTime()
+    volatile uint16_t fired;        // sigma-delta half-cycles fired this cycle
+    uint16_t firedAt;               // value of fires when it last fired
+    volatile bool cut;
+    volatile uint8_t level;         // as last written to the pin
+  };
+  static void IRAM_ATTR onTimer();
+  static void IRAM_ATTR setOutput(Channel &channel, uint8_t level);
+  static void IRAM_ATTR setOutputs(uint8_t on);
+  static void IRAM_ATTR onSigmaDelta();
+  static void IRAM_ATTR onSlot();
+  static void IRAM_ATTR planCycle();
+  static uint16_t IRAM_ATTR slotLoad(uint16_t slot);
+  static uint32_t IRAM_ATTR slotEnd(uint16_t slot);
+  static void restart();
+  static Channel outputs[SSR_MAX_CHANNELS];
+  static uint8_t nChannels;
+  static uint32_t cycleMs;
+  static uint16_t budgetDeciAmps;  // 0 for no budget
+  static uint8_t maxPriority;
+  static uint16_t slotMs, nSlots;
+  static uint8_t plan[SSR_MAX_SLOTS];  // channels on in each slot, a bit each
+  static uint16_t cycleHalfCycles, halfCycle;
+  static uint16_t fires;  // half-cycles fired by any channel, to stamp firedAt
+  static volatile SsrMode mode;
+  static volatile uint32_t positionMs;  // time within the cycle of the current interrupt
+};
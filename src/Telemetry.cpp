@@ -0,0 +1,147 @@
+#include "Telemetry.h"
+
+Telemetry::Telemetry()
+  : full(false), signal(0), included(0), all(false), checkMillis(0), publishMillis(0),
+    burstMillis(0 - TELEMETRY_BURST_TIME), nUpdates(0), nSent(0), nSuppressed(0),
+    updateSent(0), updateSuppressed(0) {
+  for (uint8_t i = 0; i < TELEMETRY_MAX_SIGNALS; i++) last[i].value = NAN;
+  timestamp.add(".sv", "timestamp");
+}
+
+// Start an update if the signals are due to be looked at. Returns false if
+// not, in which case nothing should be added.
+
+bool Telemetry::begin() {
+  uint32_t now = millis();
+  bool bursting = now - burstMillis < TELEMETRY_BURST_TIME;
+  all = !nUpdates || now - publishMillis >= TELEMETRY_MAX_INTERVAL;
+  if (!all && now - checkMillis < (bursting ? TELEMETRY_BURST_INTERVAL : TELEMETRY_MIN_INTERVAL)) {
+    return false;
+  }
+  checkMillis = now;
+  data.clear();
+  full = false;
+  signal = 0;
+  included = 0;
+  updateSent = 0;
+  updateSuppressed = 0;
+  memcpy(staged, last, sizeof(staged));
+  return true;
+}
+
+// Add a value, for the board if zone is -1, otherwise under zones/<zone>.
+// It goes out if it moved by more than deadband.
+
+void Telemetry::add(int8_t zone, const char *name, float value, float deadband, uint8_t decimals) {
+  if (!take(value, deadband)) return;
+  addValue(zone, name, value, decimals);
+}
+
+// Add a value that goes out if anything added before it does
+
+void Telemetry::addDetail(int8_t zone, const char *name, float value, uint8_t decimals) {
+  if (!included) {
+    updateSuppressed++;
+    return;
+  }
+  updateSent++;
+  addValue(zone, name, value, decimals);
+}
+
+// Rounded to decimals, so the float doesn't go out with all its digits. NAN
+// goes out as null, which clears the value in the database.
+
+void Telemetry::addValue(int8_t zone, const char *name, float value, uint8_t decimals) {
+  double scale = pow(10, decimals);
+  data.add(key(zone, name), round(value * scale) / scale);
+}
+
+// Add a string value, which goes out when it changes
+
+void Telemetry::addText(int8_t zone, const char *name, const char *text) {
+  if (!takeText(text)) return;
+  data.add(key(zone, name), text);
+}
+
+// Finish the update. Returns true if there is anything to publish, false if
+// nothing moved or there are too many signals. With nothing to publish
+// there is nothing to wait for, so what was suppressed is counted at once.
+
+bool Telemetry::end() {
+  if (!included) {
+    nSuppressed += updateSuppressed;
+    updateSuppressed = 0;
+    return false;
+  }
+  if (full) {
+    Serial.println("Telemetry has more than TELEMETRY_MAX_SIGNALS signals");
+    return false;
+  }
+  data.add("time", timestamp);
+  data.add("telemetry/sent", nSent + updateSent);
+  data.add("telemetry/suppressed", nSuppressed + updateSuppressed);
+  return true;
+}
+
+// Count the update as published, once it was sent
+
+void Telemetry::commit() {
+  memcpy(last, staged, sizeof(last));
+  nSent += updateSent;
+  nSuppressed += updateSuppressed;
+  updateSent = 0;
+  updateSuppressed = 0;
+  nUpdates++;
+  publishMillis = checkMillis;  // when the update began, not after the send
+}
+
+// Decide whether the next signal goes out, and count it with the update
+
+bool Telemetry::take(float value, float deadband) {
+  if (!next()) return false;
+  float previous = last[signal].value;
+  Slot slot;
+  slot.value = value;
+  return stage(slot, all || isnan(previous) || fabs(value - previous) > deadband);
+}
+
+// As take(), for a text. The slot keeps a 32-bit hash of it rather than the
+// text, which a float couldn't hold exactly. A text that was never published
+// goes out regardless, as the first update has everything.
+
+bool Telemetry::takeText(const char *text) {
+  if (!next()) return false;
+  Slot slot;
+  slot.hash = 2166136261u;
+  for (const char *c = text; *c; c++) slot.hash = (slot.hash ^ (uint8_t) *c) * 16777619u;
+  return stage(slot, all || slot.hash != last[signal].hash);
+}
+
+// True if there is a slot for the next signal
+
+bool Telemetry::next() {
+  if (signal < TELEMETRY_MAX_SIGNALS) return true;
+  full = true;
+  return false;
+}
+
+bool Telemetry::stage(Slot slot, bool moved) {
+  if (!moved) {
+    signal++;
+    updateSuppressed++;
+    return false;
+  }
+  staged[signal++] = slot;
+  updateSent++;
+  return true;
+}
+
+// The key for a value, a path below the board's node, valid until the next
+// call
+
+const char *Telemetry::key(int8_t zone, const char *name) {
+  included++;
+  if (zone < 0) return name;
+  snprintf(keyBuf, sizeof(keyBuf), "zones/%d/%s", zone, name);
+  return keyBuf;
+}
@@ -0,0 +1,69 @@
+// Change-driven telemetry. Signals are looked at every
+// TELEMETRY_MIN_INTERVAL, or every TELEMETRY_BURST_INTERVAL for
+// TELEMETRY_BURST_TIME after burst(), e.g. on a set point change or during
+// a ramp, and one is only published if it has moved by more than its
+// deadband since it last was. Every TELEMETRY_MAX_INTERVAL everything is
+// published whether it moved or not, so the database never goes stale for
+// long. During long holds, when little moves, most values are suppressed.
+// What an update takes is only counted as published once commit() is
+// called after it was sent, so values in an update that failed go out
+// again next time.
+// Details, such as controller internals that move all the time, have no
+// deadband and only go out along with other values.
+//
+// An update is built in one FirebaseJson kept for the life of the task and
+// cleared for each check, ready for a multi-path update: each key a path
+// below the board's node, with a server timestamp and the counts of values
+// sent and suppressed. Values are added to it
+// directly, with the key taken as is, so there is no JSON text to format
+// and parse again each time. Signals are told apart by the order they are
+// added in, which must be the same every time.
+
+#include <Arduino.h>
+#include <json/FirebaseJson.h>
+
+#define TELEMETRY_MIN_INTERVAL 2000
+#define TELEMETRY_BURST_INTERVAL 500
+#define TELEMETRY_BURST_TIME 10000
+#define TELEMETRY_MAX_INTERVAL 60000
+#define TELEMETRY_MAX_SIGNALS 48
+#define TELEMETRY_KEY_SIZE 40
+
+class Telemetry {
+public:
+  Telemetry();
+  void burst() { burstMillis = millis(); }
+  bool begin();
+  void add(int8_t zone, const char *name, float value, float deadband, uint8_t decimals);
+  void addText(int8_t zone, const char *name, const char *text);
+  void addDetail(int8_t zone, const char *name, float value, uint8_t decimals);
+  bool end();
+  void commit();
+  FirebaseJson &json() { return data; }
+  uint32_t updates() const { return nUpdates; }
+  uint32_t sent() const { return nSent; }
+  uint32_t suppressed() const { return nSuppressed; }
+private:
+  union Slot {
+    float value;
+    uint32_t hash;  // of a text, FNV-1a
+  };
+  bool take(float value, float deadband);
+  bool takeText(const char *text);
+  bool next();
+  bool stage(Slot slot, bool moved);
+  const char *key(int8_t zone, const char *name);
+  void addValue(int8_t zone, const char *name, float value, uint8_t decimals);
+
+  FirebaseJson data, timestamp;
+  char keyBuf[TELEMETRY_KEY_SIZE];
+  bool full;         // more signals than TELEMETRY_MAX_SIGNALS
+  Slot last[TELEMETRY_MAX_SIGNALS];    // as last published, NAN if never
+  Slot staged[TELEMETRY_MAX_SIGNALS];  // as last, with what the update takes
+  uint8_t signal;    // next signal of the update
+  uint8_t included;  // signals in the update
+  bool all;          // publish everything this time
+  uint32_t checkMillis, publishMillis, burstMillis;
+  uint32_t nUpdates, nSent, nSuppressed;
+  uint32_t updateSent, updateSuppressed;  // counts of the update, until committed
+};
@@ -0,0 +1,113 @@
+#include "TempEstimator.h"
+
+// Noise levels: of the filtered readings (C), of the temperature beyond the
+// model (C/sqrt(s)) and of the drift in losses (C/s/sqrt(s))
+
+#define READING_SIGMA 0.05
+#define TEMP_SIGMA 0.01
+#define LOSS_SIGMA 0.0005
+
+// Initial uncertainty of the loss rate, up to the full heating rate
+
+#define LOSS_START_SIGMA 0.03
+
+TempEstimator::TempEstimator(float heatRate)
+  : heatRate(heatRate), duty(0), temp(0), loss(0), p00(0), p01(0), p11(0),
+    initialized(false), jumps(0), goodReadings(0), stuckRef(0), stuckLoss(0), stuckRise(0),
+    probeCheck(PROBE_OK) {}
+
+// Forget the state, e.g. while the converter reports a fault. The next
+// reading starts the filter again; plausibility checks carry on.
+
+void TempEstimator::reset() {
+  initialized = false;
+}
+
+// Take a reading, dt seconds after the previous one, and the heater duty
+// (0-1) from now until the next one. regulating is true while a controller
+// holds the reading near its set point.
+
+void TempEstimator::update(float measured, float duty, float dt, bool regulating) {
+  if (measured < PROBE_MIN_TEMP || measured > PROBE_MAX_TEMP) {
+    fail(PROBE_OUT_OF_RANGE);
+    initialized = false;
+    return;
+  }
+  if (!initialized) {
+    start(measured);
+    this->duty = duty;
+    return;
+  }
+
+  // Predict with the duty of the interval just past
+
+  temp += dt * (heatRate * this->duty - loss);
+  p00 += dt * (dt * p11 - 2 * p01) + TEMP_SIGMA * TEMP_SIGMA * dt;
+  p01 -= dt * p11;
+  p11 += LOSS_SIGMA * LOSS_SIGMA * dt;
+
+  // Correct with the reading, unless it is too far out to trust
+
+  float y = measured - temp;
+  float s = p00 + READING_SIGMA * READING_SIGMA;
+  bool jumped = y * y > PROBE_JUMP_SIGMA * PROBE_JUMP_SIGMA * s;
+  if (jumped && ++jumps >= PROBE_JUMP_READINGS) {
+    fail(PROBE_JUMP);
+    start(measured);
+  } else {
+    if (!jumped) jumps = 0;
+    float k0 = p00 / s;
+    float k1 = p01 / s;
+    temp += k0 * y;
+    loss += k1 * y;
+    p11 -= k1 * p01;
+    p01 -= k0 * p01;
+    p00 -= k0 * p00;
+  }
+  this->duty = duty;
+
+  // Energy put in beyond the losses since the reading last moved, as
+  // degrees of rise
+
+  if (fabsf(measured - stuckRef) > PROBE_STUCK_DELTA || measured > PROBE_STUCK_MAX_TEMP ||
+      regulating) {
+    stuckRef = measured;
+    stuckLoss = max(loss, 0.0f);
+    stuckRise = 0;
+  } else {
+    stuckRise = max(stuckRise + (heatRate * duty - stuckLoss) * dt, 0.0f);
+    if (stuckRise > PROBE_STUCK_RISE || probeCheck == PROBE_STUCK) fail(PROBE_STUCK);
+  }
+
+  if (jumps == 0 && probeCheck != PROBE_OK && ++goodReadings >= PROBE_RECOVER_READINGS) {
+    probeCheck = PROBE_OK;
+  }
+}
+
+// Seconds until the estimate reaches target at the current rate, or NAN if
+// it isn't heading there
+
+float TempEstimator::secondsTo(float target) const {
+  float r = rate();
+  float d = target - temp;
+  if (!initialized || d * r <= 0) return NAN;
+  return d / r;
+}
+
+void TempEstimator::start(float measured) {
+  temp = measured;
+  loss = 0;
+  p00 = READING_SIGMA * READING_SIGMA;
+  p01 = 0;
+  p11 = LOSS_START_SIGMA * LOSS_START_SIGMA;
+  initialized = true;
+  jumps = 0;
+  stuckRef = measured;
+  stuckLoss = 0;
+  stuckRise = 0;
+}
+
+void TempEstimator::fail(ProbeCheck check) {
+  probeCheck = check;
+  goodReadings = 0;
+}
@@ -0,0 +1,67 @@
+// Kalman filter tracking the kettle temperature and its rate of rise from
+// RTD readings and the heater duty. The model is
+//
+//   dT/dt = heatRate * duty - loss
+//
+// where heatRate is the rise at full power with no losses, in C/s, and the
+// loss rate is a second state that drifts slowly. The duty therefore moves
+// the rate estimate as soon as it changes, rather than once the readings
+// show it.
+//
+// The readings are also checked for plausibility, which catches probe
+// failures the converter doesn't flag:
+//
+//   out of range  a reading outside PROBE_MIN_TEMP..PROBE_MAX_TEMP
+//   jump          PROBE_JUMP_READINGS readings in a row more than
+//                 PROBE_JUMP_SIGMA standard deviations from the prediction;
+//                 the filter then restarts from the reading
+//   stuck         the heater has put in enough energy, beyond what the
+//                 losses took, for PROBE_STUCK_RISE without the reading
+//                 moving PROBE_STUCK_DELTA; not checked above
+//                 PROBE_STUCK_MAX_TEMP, where the kettle may be boiling, or
+//                 while the controller is regulating within PROBE_STUCK_DELTA
+//                 of its set point, where a steady reading is the aim
+//
+// The losses for the stuck check are the estimate when the reading last
+// moved, since a stuck reading would soon teach the filter that the losses
+// take all the heat. A failed check clears after PROBE_RECOVER_READINGS good
+// readings; a stuck probe only once its reading moves.
+
+#include <Arduino.h>
+
+#define PROBE_MIN_TEMP -20
+#define PROBE_MAX_TEMP 150
+#define PROBE_JUMP_SIGMA 6
+#define PROBE_JUMP_READINGS 5
+#define PROBE_STUCK_RISE 5.0
+#define PROBE_STUCK_DELTA 0.5
+#define PROBE_STUCK_MAX_TEMP 85
+#define PROBE_RECOVER_READINGS 50
+
+typedef enum { PROBE_OK=0, PROBE_OUT_OF_RANGE, PROBE_JUMP, PROBE_STUCK } ProbeCheck;
+
+class TempEstimator {
+public:
+  TempEstimator(float heatRate);
+  void update(float measured, float duty, float dt, bool regulating = false);
+  void reset();
+  bool valid() const { return initialized; }
+  float temperature() const { return temp; }
+  float rate() const { return heatRate * duty - loss; }
+  float lossRate() const { return loss; }
+  float secondsTo(float target) const;
+  ProbeCheck check() const { return probeCheck; }
+private:
+  void start(float measured);
+  void fail(ProbeCheck check);
+
+  float heatRate;
+  float duty;     // duty applied since the last reading
+  float temp, loss;
+  float p00, p01, p11;  // covariance, symmetric
+  bool initialized;
+  uint8_t jumps;
+  uint16_t goodReadings;
+  float stuckRef, stuckLoss, stuckRise;
+  ProbeCheck probeCheck;
+};
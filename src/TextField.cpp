@@ -0,0 +1,64 @@
+#include "TextField.h"
+
+// Glyph cell of the built-in 5x7 font, including the spacing column and row
+
+#define CELL_WIDTH 6
+#define CELL_HEIGHT 8
+
+TextField::TextField(int16_t x, int16_t y, uint8_t size, uint16_t color, uint16_t bg,
+                     Adafruit_ILI9341_GlyphCache *pCache)
+  : x(x), y(y), size(size), color(color), bg(bg), pCache(pCache), valid(false), lastLen(0),
+    lastX(0) {}
+
+// Forget what is on screen, e.g. after it has been cleared, so the next
+// draw sends every cell
+
+void TextField::invalidate() {
+  valid = false;
+}
+
+void TextField::draw(Adafruit_ILI9341 *pTft, const char *text) {
+  uint8_t len = strnlen(text, TEXT_FIELD_MAX_CHARS);
+  int16_t cellW = CELL_WIDTH * size;
+  int16_t cellH = CELL_HEIGHT * size;
+  int16_t left = x - len * cellW / 2;
+  int16_t right = left + len * cellW;
+
+  // Erase whatever the previous text covered outside the new one
+
+  if (valid) {
+    int16_t lastRight = lastX + lastLen * cellW;
+    if (lastX < left) {
+      pTft->fillRect(lastX, y, min(left, lastRight) - lastX, cellH, bg);
+    }
+    if (lastRight > right) {
+      int16_t from = max(right, lastX);
+      pTft->fillRect(from, y, lastRight - from, cellH, bg);
+    }
+  }
+
+  // Cells that hold the same character at the same place are left alone
+
+  bool aligned = valid && left == lastX;
+  uint8_t i = 0;
+  while (i < len) {
+    if (aligned && i < lastLen && text[i] == last[i]) {
+      i++;
+      continue;
+    }
+    uint8_t start = i;
+    while (i < len && !(aligned && i < lastLen && text[i] == last[i])) i++;
+    if (pCache) {
+      pTft->drawCachedString(left + start * cellW, y, text + start, i - start, *pCache);
+    } else {
+      for (uint8_t j = start; j < i; j++) {
+        pTft->drawGlyph(left + j * cellW, y, text[j], color, bg, size, size);
+      }
+    }
+  }
+
+  memcpy(last, text, len);
+  lastLen = len;
+  lastX = left;
+  valid = true;
+}
@@ -0,0 +1,26 @@
+// Centered line of text in the built-in font that keeps what it last drew
+// and only sends the glyph cells that changed. Runs of changed cells are
+// drawn from a glyph cache when one is given.
+
+#include <Arduino.h>
+
+#include "Adafruit_ILI9341esp.h"
+
+#define TEXT_FIELD_MAX_CHARS 32
+
+class TextField {
+public:
+  TextField(int16_t x, int16_t y, uint8_t size, uint16_t color, uint16_t bg,
+            Adafruit_ILI9341_GlyphCache *pCache = NULL);
+  void draw(Adafruit_ILI9341 *pTft, const char *text);
+  void invalidate();
+private:
+  int16_t x, y;
+  uint8_t size;
+  uint16_t color, bg;
+  Adafruit_ILI9341_GlyphCache *pCache;
+  bool valid;
+  char last[TEXT_FIELD_MAX_CHARS];
+  uint8_t lastLen;
+  int16_t lastX;
+};
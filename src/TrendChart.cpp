@@ -0,0 +1,148 @@
+#include "TrendChart.h"
+
+// Layout: axis labels and legend in a fixed area on the left, then the
+// scrolling columns, which fill the rest of the 320 frame memory lines
+
+#define CHART_LEFT (ILI9341_TFTHEIGHT - TREND_CHART_COLUMNS)
+#define CHART_TOP 10
+#define CHART_MAX 100
+#define NO_VALUE INT16_MIN
+
+#define GRID_COLOR ILI9341_DARKGREY
+#define TEMP_COLOR ILI9341_RED
+#define SETPOINT_COLOR ILI9341_YELLOW
+#define OUTPUT_COLOR ILI9341_CYAN
+
+uint8_t TrendChart::column[ILI9341_TFTWIDTH * 2];
+
+TrendChart::TrendChart() : count(0), redrawNext(0) {}
+
+// Record one sample. Temperatures are in degrees C, output is 0-1.
+
+void TrendChart::addSample(float temp, float setPoint, float output) {
+  Sample &s = samples[count % TREND_CHART_COLUMNS];
+  s.temp = isnan(temp) ? NO_VALUE : constrain(temp, -100, 1000) * 10;
+  s.setPoint = constrain(setPoint, -100, 1000) * 10;
+  s.output = constrain(output, 0, 1) * 100;
+  count++;
+}
+
+// Screen row for a value in tenths of the chart scale, clamped to the chart
+
+static int16_t rowOf(int16_t tenths) {
+  int32_t row = (TREND_CHART_HEIGHT - 1) -
+                (int32_t)tenths * (TREND_CHART_HEIGHT - 1) / (CHART_MAX * 10);
+  return CHART_TOP + constrain(row, 0, TREND_CHART_HEIGHT - 1);
+}
+
+static void setPixel(uint8_t *column, int16_t row, uint16_t color) {
+  column[row * 2] = color >> 8;
+  column[row * 2 + 1] = color;
+}
+
+// Vertical span from the previous value to this one, so traces stay joined
+// when they move by more than a pixel between samples
+
+static void setSpan(uint8_t *column, int16_t from, int16_t to, uint16_t color) {
+  if (from > to) {
+    int16_t tmp = from;
+    from = to;
+    to = tmp;
+  }
+  for (int16_t row = from; row <= to; row++) {
+    setPixel(column, row, color);
+  }
+}
+
+// Draw sample n into its frame memory line. A negative n, from before the
+// first sample, draws an empty column.
+
+void TrendChart::drawColumn(Adafruit_ILI9341 *pTft, int32_t n) {
+  memset(column, 0, sizeof(column));
+  for (uint8_t i = 0; i <= 4; i++) {
+    setPixel(column, rowOf(i * CHART_MAX * 10 / 4), GRID_COLOR);
+  }
+
+  if (n >= 0) {
+    const Sample &s = samples[n % TREND_CHART_COLUMNS];
+    const Sample *prev = n > 0 ? &samples[(n - 1) % TREND_CHART_COLUMNS] : NULL;
+    if (n - 1 + TREND_CHART_COLUMNS < (int32_t)count) prev = NULL;
+    int16_t row = rowOf(s.output * 10);
+    setSpan(column, prev ? rowOf(prev->output * 10) : row, row, OUTPUT_COLOR);
+    row = rowOf(s.setPoint);
+    setSpan(column, prev ? rowOf(prev->setPoint) : row, row, SETPOINT_COLOR);
+    if (s.temp != NO_VALUE) {
+      row = rowOf(s.temp);
+      bool joined = prev && prev->temp != NO_VALUE;
+      setSpan(column, joined ? rowOf(prev->temp) : row, row, TEMP_COLOR);
+    }
+  }
+
+  int16_t line = CHART_LEFT + (n + TREND_CHART_COLUMNS) % TREND_CHART_COLUMNS;
+  pTft->writePixels(line, 0, 1, ILI9341_TFTWIDTH, column);
+}
+
+// Start drawing the chart, newest sample on the right. Expects rotation 1.
+// This clears the fixed area and draws the labels; drawMore() fills in the
+// samples, whose columns cover the rest of the screen.
+
+void TrendChart::draw(Adafruit_ILI9341 *pTft) {
+  pTft->setScrollArea(CHART_LEFT, 0);
+  pTft->scrollTo(CHART_LEFT + count % TREND_CHART_COLUMNS);
+  pTft->fillRect(0, 0, CHART_LEFT, pTft->height(), ILI9341_BLACK);
+  pTft->setTextSize(1);
+
+  // Axis labels and legend
+
+  pTft->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+  for (uint8_t i = 0; i <= 4; i++) {
+    int16_t value = i * CHART_MAX / 4;
+    pTft->setCursor(CHART_LEFT - 6 - (value >= 100 ? 18 : value >= 10 ? 12 : 6),
+                    rowOf(value * 10) - 3);
+    pTft->print(value);
+  }
+  pTft->setTextColor(TEMP_COLOR, ILI9341_BLACK);
+  pTft->setCursor(2, CHART_TOP + TREND_CHART_HEIGHT + 2);
+  pTft->print("Temp");
+  pTft->setTextColor(SETPOINT_COLOR, ILI9341_BLACK);
+  pTft->setCursor(2, CHART_TOP + TREND_CHART_HEIGHT + 10);
+  pTft->print("Set");
+  pTft->setTextColor(OUTPUT_COLOR, ILI9341_BLACK);
+  pTft->setCursor(2, CHART_TOP + TREND_CHART_HEIGHT + 18);
+  pTft->print("Out %");
+
+  redrawNext = (int32_t)count - TREND_CHART_COLUMNS;
+}
+
+// Draw up to `columns` more samples of a chart started by draw(). Sample n
+// lives on line CHART_LEFT + n % TREND_CHART_COLUMNS and the scroll address
+// puts the line after the newest sample at the left edge. Returns false once
+// there is nothing left to draw.
+
+bool TrendChart::drawMore(Adafruit_ILI9341 *pTft, uint16_t columns) {
+  if (redrawNext >= (int32_t)count) return false;
+  while (columns-- && redrawNext < (int32_t)count) {
+    // Lines reused by samples added since draw() have been drawn already
+    if (redrawNext + TREND_CHART_COLUMNS >= (int32_t)count) {
+      drawColumn(pTft, redrawNext);
+    }
+    redrawNext++;
+  }
+  return true;
+}
+
+// Add the newest sample to a chart already on screen
+
+void TrendChart::drawLatest(Adafruit_ILI9341 *pTft) {
+  if (count == 0) return;
+  drawColumn(pTft, count - 1);
+  pTft->scrollTo(CHART_LEFT + count % TREND_CHART_COLUMNS);
+}
+
+// Stop scrolling before another screen is drawn
+
+void TrendChart::close(Adafruit_ILI9341 *pTft) {
+  redrawNext = count;
+  pTft->setScrollArea(0, 0);
+  pTft->scrollTo(0);
+}
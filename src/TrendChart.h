@@ -0,0 +1,34 @@
+// Scrolling chart of temperature, setpoint and output power for the
+// landscape screen. Samples are kept in a ring buffer with one entry per
+// chart column. Frame memory lines run left to right in landscape, so the
+// panel's vertical scrolling moves the chart sideways: each new sample costs
+// one column write and a scroll register update instead of a redraw. A full
+// redraw is spread over drawMore() calls so it can be interleaved with other
+// work.
+
+#include <Arduino.h>
+
+#include "Adafruit_ILI9341esp.h"
+
+#define TREND_CHART_COLUMNS 280
+#define TREND_CHART_HEIGHT 200
+
+class TrendChart {
+public:
+  TrendChart();
+  void addSample(float temp, float setPoint, float output);
+  void draw(Adafruit_ILI9341 *pTft);
+  bool drawMore(Adafruit_ILI9341 *pTft, uint16_t columns);
+  void drawLatest(Adafruit_ILI9341 *pTft);
+  void close(Adafruit_ILI9341 *pTft);
+private:
+  struct Sample {
+    int16_t temp, setPoint;  // tenths of a degree
+    uint8_t output;          // percent
+  };
+  void drawColumn(Adafruit_ILI9341 *pTft, int32_t n);
+  Sample samples[TREND_CHART_COLUMNS];
+  uint32_t count;
+  int32_t redrawNext;  // next sample to draw after draw(), or count when done
+  static uint8_t column[ILI9341_TFTWIDTH * 2];  // full height, margins included, for all charts
+};
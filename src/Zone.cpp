@@ -0,0 +1,298 @@
+#include "Zone.h"
+#include "SpiBus.h"
+#include "SsrTimer.h"
+
+// The one-kettle board: RTD converter CS on D0/GPIO16, SSR on D1/GPIO5,
+// PT100 with a 430 ohm reference. HEAT_RATE is for 2 kW into 20 l of water,
+// AMPS for 2 kW at 230 V.
+
+#define DEFAULT_RTD_CS 16
+#define DEFAULT_SSR_PIN 5
+#define RNOMINAL 100.0
+#define RREF 430.0
+#define HEAT_RATE 0.024
+#define AMPS 8.7
+
+// Gains until an autotune has stored some in the zone's tuning file.
+// Assuming deflection D = 2500 ms, amplitude A = 2 deg, period Pu = 120 s
+// Ku = 4 * D / A * pi, Kp = 0.6 * Ku, Ki = 1.2 * Ku / Pu, Kd = 0.075 * Ku * Pu
+
+#define PID_KP 9424.8
+#define PID_KI 157.08
+#define PID_KD 141372
+
+// Read up to ZONES_MAX zones from path into configs, or the default zone if
+// there is no file or it has no valid zones, and the current budget, 0 if
+// none. Returns the number of zones.
+
+uint8_t Zone::loadConfig(const char *path, ZoneConfig *configs, float &budgetAmps) {
+  FirebaseJson json;
+  File f = LittleFS.open(path, "r");
+  if (f) {
+    json.readFrom(f);
+    f.close();
+  }
+  uint8_t n = 0;
+  FirebaseJsonData rtdCs, ssrPin, result;
+  budgetAmps = json.get(result, "budgetAmps") ? result.to<float>() : 0;
+  while (n < ZONES_MAX) {
+    String prefix = "zones/[" + String(n) + "]/";
+    if (!json.get(rtdCs, prefix + "rtdCs") || !json.get(ssrPin, prefix + "ssrPin")) break;
+    ZoneConfig &c = configs[n];
+    String name = json.get(result, prefix + "name") ? result.to<String>() : "Zone " + String(n + 1);
+    strncpy(c.name, name.c_str(), ZONE_NAME_LEN - 1);
+    c.name[ZONE_NAME_LEN - 1] = 0;
+    c.rtdCs = rtdCs.to<int>();
+    c.ssrPin = ssrPin.to<int>();
+    c.ledPin = json.get(result, prefix + "ledPin") ? result.to<int>() : (n ? -1 : LED_BUILTIN);
+    int wires = json.get(result, prefix + "wires") ? result.to<int>() : 3;
+    c.wires = wires == 2 ? MAX31865_2WIRE : wires == 4 ? MAX31865_4WIRE : MAX31865_3WIRE;
+    c.rNominal = json.get(result, prefix + "rNominal") ? result.to<float>() : RNOMINAL;
+    c.rRef = json.get(result, prefix + "rRef") ? result.to<float>() : RREF;
+    c.heatRate = json.get(result, prefix + "heatRate") ? result.to<float>() : HEAT_RATE;
+    c.amps = json.get(result, prefix + "amps") ? result.to<float>() : AMPS;
+    int priority = json.get(result, prefix + "priority") ? result.to<int>() : 0;
+    c.priority = constrain(priority, 0, SSR_MAX_CHANNELS - 1);
+    n++;
+  }
+  if (n == 0) {
+    configs[0] = { "Kettle", DEFAULT_RTD_CS, DEFAULT_SSR_PIN, LED_BUILTIN, MAX31865_3WIRE,
+                   RNOMINAL, RREF, HEAT_RATE, AMPS, 0 };
+    n = 1;
+  }
+  return n;
+}
+
+// Each RTD reading goes through a median of 3, which drops single bad
+// readings, and a light low pass that keeps noise out of the PID's
+// derivative term.
+
+Zone::Zone(uint8_t index, const ZoneConfig &config)
+  : zoneIndex(index), config(config),
+    tuningFile(index ? "/pid-tuning-" + String(index) + ".json" : String(PID_TUNING_FILE)),
+    profileFile(index ? "/profile-" + String(index) + ".json" : String(PROFILE_FILE)),
+    thermo(config.rtdCs), rtdSensor(thermo, config.rtdCs), rtdFilter(1, 3, 2),
+    tempEstimator(config.heatRate), ssrChannel(-1), rtdTemp(0), rtdFault(0),
+    lastReadingMillis(0), tempEstimate(0), setPoint(0), controlState(CONTROL_OFF), pidOut(0),
+    tempPID(&tempEstimate, &pidOut, &setPoint, PID_KP, PID_KI, PID_KD, DIRECT),
+    gainSchedule(PID_KP, PID_KI, PID_KD), gainBand(0), autotune(SSR_CYCLE_TIME),
+    autotuneOut(0), feedForward(0), setPointRamp(0), rampMillis(0), rampFrom(0), timeOnMs(0) {}
+
+// Set up the converter and the SSR output, and load the PID tuning. The
+// first conversion starts after delayMs, so zones can take turns on the bus.
+// SsrTimer is started once all zones have their channels.
+
+void Zone::begin(RtdFilter filter, uint32_t samplePeriodMs, uint32_t delayMs) {
+  ssrChannel = SsrTimer::addChannel(config.ssrPin, config.ledPin, config.amps, config.priority);
+  int8_t spiDevice = SpiBus::addDevice(config.rtdCs, RTD_SPI_FREQ, SPI_MODE1);
+  pinMode(config.rtdCs, OUTPUT);
+  rtdConverter.begin(thermo, config.rNominal, config.rRef);
+  rtdSensor.begin(spiDevice, config.wires, filter, samplePeriodMs, delayMs);
+  tempPID.SetOutputLimits(0, SSR_CYCLE_TIME);
+  tempPID.SetMode(AUTOMATIC);
+  if (gainSchedule.load(tuningFile.c_str())) {
+    applyGains(gainSchedule.bandOf(setPoint));
+  }
+}
+
+// Step the RTD acquisition. Returns the time in ms until the next step.
+
+uint32_t Zone::pollRtd() {
+  uint32_t nextMs = rtdSensor.poll();
+  if (rtdSensor.available()) {
+    int32_t centiDegrees = rtdConverter.centiDegrees(rtdSensor.read());
+    rtdFault = rtdSensor.fault();
+
+    // A faulted reading is meaningless, so hold the last temperature and
+    // start the filters afresh once the probe is back
+
+    if (rtdFault) {
+      rtdFilter.reset();
+      tempEstimator.reset();
+    } else {
+      rtdFilter.add(centiDegrees);
+      rtdTemp = rtdFilter.value() / 100.0;
+      bool regulating = controlState == CONTROL_PID && fabs(rtdTemp - setPoint) <= PROBE_STUCK_DELTA;
+      tempEstimator.update(rtdTemp, (float) timeOnMs / SSR_CYCLE_TIME,
+                           (millis() - lastReadingMillis) / 1000.0, regulating);
+      tempEstimate = tempEstimator.temperature();
+    }
+    lastReadingMillis = millis();
+  }
+  return nextMs;
+}
+
+// A set point from outside overrides a running profile
+
+void Zone::setSetPoint(double setPoint) {
+  if (mashProfile.running()) {
+    Serial.printf("%s: profile stopped by a new set point\n", config.name);
+    mashProfile.stop();
+  }
+  this->setPoint = setPoint;
+}
+
+// Only PID control follows a profile, so other states stop it
+
+void Zone::setControlState(ControlState state) {
+  if (state != CONTROL_PID) mashProfile.stop();
+  if (state == CONTROL_AUTOTUNE && controlState != CONTROL_AUTOTUNE) {
+    Serial.printf("%s: starting autotune around %f\n", config.name, setPoint);
+    autotune.begin(setPoint);
+  } else if (state != CONTROL_AUTOTUNE) {
+    autotune.cancel();
+  }
+  controlState = state;
+}
+
+// Load the zone's profile and run it under PID control, ramping from the
+// current temperature if it is known. Returns false if there is no profile.
+
+bool Zone::startProfile() {
+  if (!mashProfile.load(profileFile.c_str())) {
+    Serial.printf("%s: no profile in %s\n", config.name, profileFile.c_str());
+    return false;
+  }
+  setControlState(CONTROL_PID);
+  mashProfile.start(probeOk() ? tempEstimate : setPoint);
+  Serial.printf("%s: running profile of %d steps\n", config.name, mashProfile.steps());
+  return true;
+}
+
+// Run the controller, with the set point from the profile if one is
+// running. The PID only computes once its own sample time (100 ms) has
+// passed. Returns true if the control state changed, which happens when an
+// autotune ends.
+
+bool Zone::control() {
+  if (mashProfile.running()) {
+    setPoint = mashProfile.update(probeOk() ? tempEstimate : NAN);
+  }
+  if (millis() - rampMillis >= SETPOINT_RAMP_WINDOW) {
+    double ramp = (setPoint - rampFrom) * 1000 / SETPOINT_RAMP_WINDOW;
+    setPointRamp = ramp > 0 && ramp <= config.heatRate ? ramp : 0;
+    rampFrom = setPoint;
+    rampMillis = millis();
+  }
+
+  if (controlState == CONTROL_AUTOTUNE) {
+    return runAutotune();
+  }
+
+  // The PID sits out boil mode, and resumes from the feedforward alone
+
+  if (boiling()) {
+    tempPID.SetMode(MANUAL);
+    return false;
+  }
+  uint8_t band = gainSchedule.bandOf(setPoint);
+  if (band != gainBand) applyGains(band);
+  float lossRate = tempEstimator.valid() ? max(tempEstimator.lossRate(), 0.0f) : 0;
+  feedForward = constrain((lossRate + setPointRamp) / config.heatRate, 0, 1) * SSR_CYCLE_TIME;
+  tempPID.SetOutputLimits(-feedForward, SSR_CYCLE_TIME - feedForward);
+  if (tempPID.GetMode() == MANUAL) {
+    pidOut = 0;
+    tempPID.SetMode(AUTOMATIC);
+  }
+  tempPID.Compute();
+  return false;
+}
+
+// Work out the SSR on time for the coming cycles and hand it to the timer.
+// Manual control follows the pot. Turning control off switches the SSR off
+// at once. Window mode needs a minimum on time; sigma-delta mode can fire
+// single half-cycles. PID control holds the heater off while the probe is
+// in doubt.
+
+void Zone::updateSsr(int potValue) {
+  unsigned long onMs = 0;
+  switch (controlState) {
+    case CONTROL_OFF:
+      onMs = 0;
+      break;
+    case CONTROL_MANUAL:
+      onMs = SSR_CYCLE_TIME * potValue / 1024;
+      break;
+    case CONTROL_PID:
+    case CONTROL_AUTOTUNE:
+      onMs = probeOk() ? output() : 0;
+      break;
+  }
+  if (onMs < 100 && SsrTimer::getMode() == SSR_MODE_WINDOW) {
+    onMs = 0;
+  }
+  if (onMs > SSR_CYCLE_TIME) {
+    onMs = SSR_CYCLE_TIME;
+  }
+  SsrTimer::setOnTime(ssrChannel, onMs);
+  if (controlState == CONTROL_OFF && SsrTimer::onTime(ssrChannel)) {
+    SsrTimer::cutOff(ssrChannel);
+  }
+  timeOnMs = SsrTimer::onTime(ssrChannel);
+}
+
+// On time per cycle under automatic control
+
+double Zone::output() const {
+  if (controlState == CONTROL_AUTOTUNE) return autotuneOut;
+  if (boiling()) return SSR_CYCLE_TIME;
+  return feedForward + pidOut;
+}
+
+bool Zone::boiling() const {
+  return controlState == CONTROL_PID && setPoint >= BOIL_SETPOINT;
+}
+
+// True if the temperature estimate can be trusted to control the heater
+
+bool Zone::probeOk() const {
+  return !rtdFault && tempEstimator.valid() && tempEstimator.check() == PROBE_OK;
+}
+
+// Switch the PID to the gains for a band of set points
+
+void Zone::applyGains(uint8_t band) {
+  const PidGains &g = gainSchedule.gains(band);
+  tempPID.SetTunings(g.kp, g.ki, g.kd);
+  gainBand = band;
+  Serial.printf("%s: PID gains for the %s band: %f %f %f\n", config.name,
+                gainSchedule.bandName(band), g.kp, g.ki, g.kd);
+}
+
+// Step the relay experiment. When it completes, the new gains are stored
+// and control carries on under PID from the relay's output, without a
+// bump. If it fails, or the probe can't be trusted, the heater goes off.
+// Returns true once the experiment is over.
+
+bool Zone::runAutotune() {
+  if (!probeOk()) {
+    autotune.cancel();
+  } else {
+    autotuneOut = autotune.update(tempEstimate);
+  }
+  switch (autotune.state()) {
+    case AUTOTUNE_RUNNING:
+      return false;
+    case AUTOTUNE_DONE: {
+      Serial.printf("%s: autotune Ku %f Pu %f s: Kp %f Ki %f Kd %f\n", config.name,
+                    autotune.ultimateGain(), autotune.ultimatePeriod(), autotune.kp(),
+                    autotune.ki(), autotune.kd());
+      uint8_t band = gainSchedule.bandOf(autotune.target());
+      gainSchedule.setGains(band, { autotune.kp(), autotune.ki(), autotune.kd(),
+                                    autotune.ultimateGain(), autotune.ultimatePeriod() });
+      gainSchedule.save(tuningFile.c_str());
+      tempPID.SetMode(MANUAL);
+      applyGains(gainSchedule.bandOf(setPoint));
+      pidOut = autotune.averageOutput() - feedForward;
+      tempPID.SetMode(AUTOMATIC);
+      controlState = CONTROL_PID;
+      break;
+    }
+    default:
+      Serial.printf("%s: autotune failed\n", config.name);
+      controlState = CONTROL_OFF;
+      break;
+  }
+  autotuneOut = 0;
+  return true;
+}
@@ -0,0 +1,136 @@
+// One heating zone: an RTD probe on the shared SPI bus, its temperature
+// estimate and PID loop, and an output of SsrTimer. A controller runs up to
+// ZONES_MAX zones side by side, e.g. HLT, mash tun and boil kettle, each
+// with its own set point, control state and PID tuning file, and a mash
+// profile that can drive its set point (see Profile.h).
+//
+// Zones are read from ZONES_FILE as
+//
+//   {"budgetAmps": 20,
+//    "zones": [{"name": "HLT", "rtdCs": 16, "ssrPin": 5, "wires": 3,
+//               "rNominal": 100, "rRef": 430, "heatRate": 0.024,
+//               "amps": 10.9, "priority": 1}, ...]}
+//
+// where every key but rtdCs and ssrPin is optional. Without the file there
+// is a single zone on the pins of the one-kettle board. With a budget the
+// elements on at any time draw no more than budgetAmps between them;
+// zones with a lower priority number get their power first, e.g. 0 for
+// the boil kettle, and zones of equal priority share evenly (see
+// SsrTimer.h).
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <json/FirebaseJson.h>
+#include <Adafruit_MAX31865.h>
+#include <PID_v1.h>
+
+#include "FilterChain.h"
+#include "GainSchedule.h"
+#include "Profile.h"
+#include "RelayAutotune.h"
+#include "RtdConverter.h"
+#include "RtdSensor.h"
+#include "TempEstimator.h"
+
+#define ZONES_MAX 3
+#define ZONES_FILE "/zones.json"
+#define ZONE_NAME_LEN 12
+
+// SSR cycle shared by all zones, and SPI clock for the RTD converters
+// (5 MHz max)
+
+#define SSR_CYCLE_TIME 5000
+#define RTD_SPI_FREQ 1000000
+
+// Tuning and mash profile of zone 0. Other zones keep theirs in
+// /pid-tuning-<n>.json and /profile-<n>.json.
+
+#define PID_TUNING_FILE "/pid-tuning.json"
+#define PROFILE_FILE "/profile.json"
+
+// Under PID control the output is a feedforward term plus the PID's
+// correction. The feedforward supplies the power the estimator says is
+// lost, plus what it takes to follow a rising set point, measured over
+// SETPOINT_RAMP_WINDOW; a faster change than the heater can follow is a
+// step rather than a ramp. From BOIL_SETPOINT up the PID is bypassed and
+// the heater runs at full power.
+
+#define SETPOINT_RAMP_WINDOW 30000
+#define BOIL_SETPOINT 98
+
+typedef enum { CONTROL_OFF=0, CONTROL_MANUAL=1, CONTROL_PID=2, CONTROL_AUTOTUNE=3 } ControlState;
+
+struct ZoneConfig {
+  char name[ZONE_NAME_LEN];
+  uint8_t rtdCs;
+  uint8_t ssrPin;
+  int8_t ledPin;   // mirrors the SSR, -1 for none
+  max31865_numwires_t wires;
+  float rNominal, rRef;
+  float heatRate;  // C/s at full power without losses
+  float amps;      // element current
+  uint8_t priority;
+};
+
+class Zone {
+public:
+  static uint8_t loadConfig(const char *path, ZoneConfig *configs, float &budgetAmps);
+
+  Zone(uint8_t index, const ZoneConfig &config);
+  void begin(RtdFilter filter, uint32_t samplePeriodMs, uint32_t delayMs);
+  uint32_t pollRtd();
+  bool control();
+  void updateSsr(int potValue);
+  void setSetPoint(double setPoint);
+  void setControlState(ControlState state);
+  bool startProfile();
+  void stopProfile() { mashProfile.stop(); }
+
+  uint8_t index() const { return zoneIndex; }
+  const char *name() const { return config.name; }
+  double temperature() const { return rtdTemp; }
+  uint8_t fault() const { return rtdFault; }
+  const TempEstimator &estimator() const { return tempEstimator; }
+  double targetTemp() const { return setPoint; }
+  ControlState state() const { return controlState; }
+  uint8_t autotuneCycles() const { return autotune.cycles(); }
+  const Profile &profile() const { return mashProfile; }
+  uint32_t onTime() const { return timeOnMs; }
+  double pidOutput() const { return pidOut; }
+  double feedForwardOutput() const { return feedForward; }
+  double output() const;
+  bool boiling() const;
+  bool probeOk() const;
+private:
+  void applyGains(uint8_t band);
+  bool runAutotune();
+
+  uint8_t zoneIndex;
+  ZoneConfig config;
+  String tuningFile;
+  String profileFile;
+  Adafruit_MAX31865 thermo;
+  RtdSensor rtdSensor;
+  RtdConverter rtdConverter;
+  FilterChain rtdFilter;
+  TempEstimator tempEstimator;
+  int8_t ssrChannel;
+  double rtdTemp;
+  uint8_t rtdFault;
+  uint32_t lastReadingMillis;
+  double tempEstimate;
+  double setPoint;
+  ControlState controlState;
+  double pidOut;
+  PID tempPID;
+  GainSchedule gainSchedule;
+  uint8_t gainBand;
+  RelayAutotune autotune;
+  double autotuneOut;
+  double feedForward;
+  double setPointRamp;  // C/s
+  uint32_t rampMillis;
+  double rampFrom;
+  Profile mashProfile;
+  uint32_t timeOnMs;
+};
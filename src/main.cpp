@@ -17,12 +17,18 @@
 #include <addons/TokenHelper.h>
 
 #include <Adafruit_GFX.h>
-#include <Adafruit_MAX31865.h>
 #include <XPT2046.h>
-#include <PID_v1.h>
 
 #include "AccessPoint.h"
+#include "ButtonPanel.h"
+#include "Scheduler.h"
+#include "SsrTimer.h"
+#include "SpiBus.h"
+#include "Telemetry.h"
+#include "TextField.h"
+#include "TrendChart.h"
 #include "Util.h"
+#include "Zone.h"
 
 // GPIO pins for TFT and touchscreen
 
@@ -31,6 +37,11 @@
 #define TOUCH_CS 4
 #define TOUCH_IRQ 5
 
+// SPI clock for the touch controller (2.5 MHz max). The display runs at
+// ESP_SPI_FREQ, set by its driver, and the RTD converters at RTD_SPI_FREQ.
+
+#define TOUCH_SPI_FREQ 2000000
+
 // WiFi parameters
 
 #define WIFI_PARAM_FILE "/wifi.json"
@@ -52,7 +63,7 @@
 #define DISPLAY_CYCLE_TIME 1000
 Adafruit_ILI9341 tft = Adafruit_ILI9341(TFT_CS, TFT_DC);
 XPT2046 touch(TOUCH_CS, TOUCH_IRQ);
-unsigned long displayMillis = 0;
+int8_t touchSpi = -1;
 
 // Operation mode
 
@@ -73,88 +84,124 @@ BearSSL::CertStore certStore;
 
 // Firebase objects
 
-#define DB_UPDATE_CYCLE_TIME 2000
 FirebaseData fbdoWrite;
 FirebaseData fbdoRead;
 FirebaseAuth auth;
 FirebaseConfig config;
 String boardID;
-unsigned long fbLoopMillis = 0;
-
-// RTD probe parameters and module setup
-
-#define RREF      430.0
-#define RNOMINAL  100.0
-int rtdPin = 16; // Pin marked D0/GPIO16 on the board, used for SPI CS
-double rtdTemp = 0;
-Adafruit_MAX31865 thermo = Adafruit_MAX31865(rtdPin); // Use D0 for SPI CS, HW SPI for MISO/MOSI/CLK
+String boardPath;  // "/" + boardID
 
-// Pins for potentiometer, SSR, input variable for potentiometer, LED output
+// Telemetry goes out as one multi-path update of the board's node, each
+// key a path below it, so values not named are left alone. Only values that
+// moved by more than their deadband are sent (see Telemetry.h), with the
+// PID internals as details; inputs from the stream and profile ramps speed
+// it up for a while.
 
-int potPin = A0;
-int sensorValue = 0;
-int ledOutput = LOW;
-#define SSR_CYCLE_TIME 5000
-int ssrPin = 5;  // Pin marked D1/SCL/GPIO5 on the board
-unsigned long dataMillis = 0;
-unsigned long ssrMillis = 0;
-unsigned long timeOnMs = 0;
+#define TELEMETRY_POT_DEADBAND 8
+#define TELEMETRY_TEMP_DEADBAND 0.1
+#define TELEMETRY_OUTPUT_DEADBAND 0.02
+#define TELEMETRY_SETPOINT_DEADBAND 0.05
+#define TELEMETRY_REMAINING_DEADBAND 30 // s
+Telemetry telemetry;
 
-// PID variables
+// Heating zones, each with its own probe, PID loop and SSR (see Zone.h).
+// Their RTD conversions are spread over RTD_SAMPLE_TIME, and the RTD task
+// polls them all.
 
-typedef enum { CONTROL_OFF=0, CONTROL_MANUAL=1, CONTROL_PID=2 } ControlState;
+Zone *zones[ZONES_MAX];
+uint8_t nZones = 0;
+int8_t rtdTask = -1;
 
-double setPoint = 0;
-ControlState controlState = CONTROL_OFF;
-double pidOut = 0;
-// Assuming deflection D = 2500 ms, amplitude A = 2 deg, period Pu = 120 s
-// Ku = 4 * D / A * pi, Kp = 0.6 * Ku, Ki = 1.2 * Ku / Pu, Kd = 0.075 * Ku * Pu
-PID tempPID(&rtdTemp, &pidOut, &setPoint, 9424.8, 157.08, 141372, DIRECT);
+// Pot for manual control, shared by the zones. It is oversampled 4x at
+// 40 Hz, then goes through a median of 3 and a light low pass.
 
-// 15 buttons, in classic candybar phone style
-
-#define MAX_BUTTONS 3
-char buttonlabels[MAX_BUTTONS][9] = { "", "", "" };
-Adafruit_GFX_Button buttons[MAX_BUTTONS];
-int nButtons = 0;
+int potPin = A0;
+int sensorValue = 0;
+FilterChain potFilter(4, 3, 1);
+
+// Buttons of the setup screens
+
+ButtonPanel buttons;
+
+// Running stats screen. Each field only redraws the characters that
+// changed since the last update; the large readouts come from a cache of
+// pre-rendered glyphs.
+
+Adafruit_ILI9341_GlyphCache readoutGlyphs(" 0123456789.-FAULT", ILI9341_GREEN, ILI9341_BLACK, 4);
+TextField headerField(160, 20, 2, ILI9341_GREEN, ILI9341_BLACK);
+TextField powerField(160, 60, 4, ILI9341_GREEN, ILI9341_BLACK, &readoutGlyphs);
+TextField tempLabelField(160, 120, 2, ILI9341_GREEN, ILI9341_BLACK);
+TextField tempField(160, 160, 4, ILI9341_GREEN, ILI9341_BLACK, &readoutGlyphs);
+TextField rateField(160, 210, 2, ILI9341_GREEN, ILI9341_BLACK);
+
+// Trend chart per zone, shown instead of the stats when the screen is
+// touched. One sample per TREND_SAMPLE_TIME, so the chart spans about 47
+// minutes. The running screens show one zone at a time; touching the chart
+// moves on to the stats of the next zone.
+
+#define TREND_SAMPLE_TIME 10000
+typedef enum { SCREEN_STATS, SCREEN_CHART } Screen;
+Screen screen = SCREEN_STATS;
+TrendChart *trendCharts[ZONES_MAX];
+uint8_t shownZone = 0;
+bool wasTouching = false;
+
+// Display work of the running screens is split into steps of at most a band
+// of the screen, a field or a few chart columns. The render task does as
+// many steps as fit in RENDER_BUDGET_US, so a redraw holds up the other
+// tasks by one step at most.
+
+#define RENDER_BUDGET_US 2000
+#define CLEAR_BANDS 16
+#define STATS_FIELDS 5
+#define CHART_COLUMNS_PER_STEP 8
+uint8_t clearBands = 0;   // bands of the screen still to clear
+uint8_t statsFields = 0;  // stats fields still to draw
+
+// Tasks run from loop() by the scheduler, in order of priority. The SSR
+// task only publishes the on times for SsrTimer, which switches the SSRs
+// from a timer interrupt, and mirrors the SSRs on their LEDs. The PID task
+// only polls: Compute() runs each controller once its own sample time
+// (100 ms) has passed. The RTD task has no period; it reschedules itself
+// for the next step of any conversion.
+
+#define SSR_UPDATE_TIME 100
+#define SENSOR_READ_TIME 25
+#define RTD_SAMPLE_TIME 100
+#define PID_POLL_TIME 20
+#define TOUCH_POLL_TIME 20
+#define RENDER_TIME 20
+#define SCHEDULER_STATS_TIME 60000
+enum { PRIORITY_SSR, PRIORITY_SENSORS, PRIORITY_PID, PRIORITY_TOUCH, PRIORITY_DISPLAY,
+       PRIORITY_TELEMETRY, PRIORITY_STATS };
 
 // Icons
 
-// 'wifi1', 40x30px
-
-const unsigned char wifi_bitmap_1 [] PROGMEM = {
-	0x00, 0x03, 0xff, 0xe0, 0x00, 0x00, 0x1f, 0xff, 0xfc, 0x00, 0x00, 0x7f, 0xff, 0xff, 0x00, 0x01, 
-	0xff, 0xff, 0xff, 0xc0, 0x03, 0xff, 0xff, 0xff, 0xe0, 0x0f, 0xff, 0xff, 0xff, 0xf8, 0x1f, 0xfc, 
-	0x00, 0x3f, 0xfc, 0x3f, 0xf0, 0x00, 0x07, 0xfe, 0x7f, 0xc0, 0x00, 0x01, 0xff, 0xff, 0x00, 0x1c, 
-	0x00, 0xff, 0xfe, 0x01, 0xff, 0xc0, 0x3f, 0xfc, 0x07, 0xff, 0xf0, 0x1f, 0x78, 0x1f, 0xff, 0xfc, 
-	0x0e, 0x30, 0x3f, 0xff, 0xfe, 0x00, 0x00, 0x7f, 0xff, 0xff, 0x00, 0x00, 0xff, 0xff, 0xff, 0x80, 
-	0x01, 0xff, 0x80, 0xff, 0x80, 0x01, 0xfe, 0x00, 0x3f, 0xc0, 0x01, 0xfc, 0x00, 0x1f, 0x80, 0x00, 
-	0xf8, 0x00, 0x0f, 0x80, 0x00, 0x70, 0x08, 0x00, 0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00, 
-	0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0x80, 0x00, 0x00, 0x01, 0xff, 0x80, 0x00, 0x00, 0x01, 0xff, 
-	0x80, 0x00, 0x00, 0x01, 0xff, 0x80, 0x00, 0x00, 0x00, 0xff, 0x80, 0x00, 0x00, 0x00, 0x7f, 0x00, 
-	0x00, 0x00, 0x00, 0x3e, 0x00, 0x00
+// 'wifi_rle_1', 40x30px, RLE (89 bytes, 150 as a bitmap)
+
+const unsigned char wifi_rle_1 [] PROGMEM = {
+	0x0e, 0x0d, 0x18, 0x13, 0x13, 0x17, 0x0f, 0x1b, 0x0c, 0x1d, 0x09, 0x21, 0x06, 0x0b, 0x0c, 0x0c,
+	0x04, 0x0a, 0x11, 0x0a, 0x02, 0x09, 0x15, 0x11, 0x0b, 0x03, 0x0a, 0x0f, 0x08, 0x0b, 0x08, 0x0c,
+	0x07, 0x0f, 0x07, 0x05, 0x01, 0x04, 0x06, 0x13, 0x06, 0x03, 0x03, 0x02, 0x06, 0x15, 0x12, 0x17,
+	0x10, 0x19, 0x0e, 0x0a, 0x07, 0x09, 0x0e, 0x08, 0x0b, 0x08, 0x0d, 0x07, 0x0d, 0x06, 0x0f, 0x05,
+	0x0f, 0x05, 0x10, 0x03, 0x08, 0x01, 0x24, 0x06, 0x21, 0x08, 0x20, 0x09, 0x1e, 0x0a, 0x1e, 0x0a,
+	0x1e, 0x0a, 0x1f, 0x09, 0x20, 0x07, 0x22, 0x05, 0x11
 };
 
-// 'wifi2', 40x40px
-
-const unsigned char wifi_bitmap_2 [] PROGMEM = {
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1c, 
-	0x00, 0x00, 0x00, 0x01, 0xff, 0xc0, 0x00, 0x00, 0x07, 0xff, 0xf0, 0x00, 0x00, 0x1f, 0xff, 0xfc, 
-	0x00, 0x00, 0x3f, 0xff, 0xfe, 0x00, 0x00, 0x7f, 0xff, 0xff, 0x00, 0x00, 0xff, 0xff, 0xff, 0x80, 
-	0x01, 0xff, 0x80, 0xff, 0x80, 0x01, 0xfe, 0x00, 0x3f, 0xc0, 0x01, 0xfc, 0x00, 0x1f, 0x80, 0x00, 
-	0xf8, 0x00, 0x0f, 0x80, 0x00, 0x70, 0x08, 0x00, 0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00, 
-	0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0x80, 0x00, 0x00, 0x01, 0xff, 0x80, 0x00, 0x00, 0x01, 0xff, 
-	0x80, 0x00, 0x00, 0x01, 0xff, 0x80, 0x00, 0x00, 0x00, 0xff, 0x80, 0x00, 0x00, 0x00, 0x7f, 0x00, 
-	0x00, 0x00, 0x00, 0x3e, 0x00, 0x00
+// 'wifi_rle_2', 40x30px, RLE (55 bytes, 150 as a bitmap)
+
+const unsigned char wifi_rle_2 [] PROGMEM = {
+	0xff, 0x00, 0x7c, 0x03, 0x21, 0x0b, 0x1b, 0x0f, 0x17, 0x13, 0x14, 0x15, 0x12, 0x17, 0x10, 0x19,
+	0x0e, 0x0a, 0x07, 0x09, 0x0e, 0x08, 0x0b, 0x08, 0x0d, 0x07, 0x0d, 0x06, 0x0f, 0x05, 0x0f, 0x05,
+	0x10, 0x03, 0x08, 0x01, 0x24, 0x06, 0x21, 0x08, 0x20, 0x09, 0x1e, 0x0a, 0x1e, 0x0a, 0x1e, 0x0a,
+	0x1f, 0x09, 0x20, 0x07, 0x22, 0x05, 0x11
 };
 
-// Array of all bitmaps for convenience. (Total bytes used to store images in PROGMEM = 176)
+// Array of all icons for convenience. (Total bytes used to store images in PROGMEM = 144)
 
-const int bitmap_allArray_LEN = 2;
-const unsigned char* bitmap_allArray[2] = {
-	wifi_bitmap_1, wifi_bitmap_2
+const int rle_allArray_LEN = 2;
+const unsigned char* rle_allArray[2] = {
+	wifi_rle_1, wifi_rle_2
 };
 
 void getWifiParams(File &fWifi, String &SSID, String &password, String &email) {
@@ -173,7 +220,7 @@ bool connectToWifi(Adafruit_ILI9341 &tft, String &SSID, String &password) {
   Serial.printf("Connecting to WiFi SSID %s\n", SSID.c_str());
   int frame = 0;
   tft.setRotation(1);
-  tft.drawBitmap(140, 105, wifi_bitmap_1, 40, 30, ILI9341_MAGENTA);
+  tft.drawRLEBitmap(140, 105, wifi_rle_1, 40, 30, ILI9341_MAGENTA, ILI9341_BLACK);
   WiFi.begin(SSID, password);
   unsigned long wifiMillis = millis();
   while (WiFi.status() != WL_CONNECTED && millis() - wifiMillis < WIFI_TIMEOUT)
@@ -181,8 +228,8 @@ bool connectToWifi(Adafruit_ILI9341 &tft, String &SSID, String &password) {
     Serial.print(".");
     delay(300);
     frame = !frame;
-    tft.fillRect(140, 105, 40, 30, ILI9341_BLACK);
-    tft.drawBitmap(140, 105, frame == 0 ? wifi_bitmap_1 : wifi_bitmap_2, 40, 30, ILI9341_MAGENTA);
+    tft.drawRLEBitmap(140, 105, frame == 0 ? wifi_rle_1 : wifi_rle_2, 40, 30,
+                      ILI9341_MAGENTA, ILI9341_BLACK);
   }
   tft.fillRect(140, 105, 40, 30, ILI9341_BLACK);
   Serial.println();
@@ -195,15 +242,10 @@ void drawNoWifi(Adafruit_ILI9341 &tft) {
   Util::drawLogo(&tft);
   Util::drawCenteredString(&tft, "WiFi timeout", 160, 70);
 
-  strcpy(buttonlabels[0], "Continue");
-  buttons[0].initButton(&tft, 80, 130, 130, 60,
-                        ILI9341_WHITE, ILI9341_GREEN, ILI9341_WHITE, buttonlabels[0], 2);
-  buttons[0].drawButton();
-  strcpy(buttonlabels[1], "Reconfig");
-  buttons[1].initButton(&tft, 240, 130, 130, 60,
-                        ILI9341_WHITE, ILI9341_RED, ILI9341_WHITE, buttonlabels[1], 2);
-  buttons[1].drawButton();
-  nButtons = 2;
+  buttons.clear();
+  buttons.add(80, 130, 130, 60, ILI9341_WHITE, ILI9341_GREEN, ILI9341_WHITE, "Continue", 2);
+  buttons.add(240, 130, 130, 60, ILI9341_WHITE, ILI9341_RED, ILI9341_WHITE, "Reconfig", 2);
+  buttons.draw(&tft);
 }
 
 String startWifi() {
@@ -293,19 +335,11 @@ void drawNeedSetupScreen(Adafruit_ILI9341 &tft, String message, String label0="C
                          String label1="Retry", String label2="Reconfig") {
   Util::drawLogo(&tft);
   Util::drawCenteredString(&tft, message, 160, 70);
-  strcpy(buttonlabels[0], label0.c_str());
-  strcpy(buttonlabels[1], label1.c_str());
-  strcpy(buttonlabels[2], label2.c_str());
-  buttons[0].initButton(&tft, 80, 130, 130, 60,
-                        ILI9341_WHITE, ILI9341_GREEN, ILI9341_WHITE, buttonlabels[0], 2);
-  buttons[1].initButton(&tft, 240, 130, 130, 60,
-                        ILI9341_WHITE, ILI9341_GREEN, ILI9341_WHITE, buttonlabels[1], 2);
-  buttons[2].initButton(&tft, 160, 200, 130, 60,
-                        ILI9341_WHITE, ILI9341_RED, ILI9341_WHITE, buttonlabels[2], 2);
-  buttons[0].drawButton();
-  buttons[1].drawButton();
-  buttons[2].drawButton();
-  nButtons = 3;
+  buttons.clear();
+  buttons.add(80, 130, 130, 60, ILI9341_WHITE, ILI9341_GREEN, ILI9341_WHITE, label0.c_str(), 2);
+  buttons.add(240, 130, 130, 60, ILI9341_WHITE, ILI9341_GREEN, ILI9341_WHITE, label1.c_str(), 2);
+  buttons.add(160, 200, 130, 60, ILI9341_WHITE, ILI9341_RED, ILI9341_WHITE, label2.c_str(), 2);
+  buttons.draw(&tft);
 }
 
 String getOrFetchToken(String &email) {
@@ -426,22 +460,48 @@ String getOrFetchCredentials(String &email) {
   return idToken;
 }
 
-// Firebase stream read callback
+// Firebase stream read callback. Zone inputs are under /zones/<n>;
+// /setPoint, /controlState and /profile at the top level go to zone 0.
+// /profile starts the zone's mash profile with 1 and stops it with 0.
 
-void streamCallback(MultiPathStream data) {
-  Serial.println("Got stream data");
-  if (data.get("/setPoint")) {
+void readZoneInputs(MultiPathStream &data, Zone *zone, const String &prefix) {
+  if (data.get(prefix + "/setPoint")) {
     Serial.print("Setpoint stream event type: "); Serial.println(data.eventType.c_str());
     Serial.printf("Value %s (%f)\n", data.value.c_str(), data.value.toFloat());
-    setPoint = data.value.toFloat();
+    zone->setSetPoint(data.value.toFloat());
   }
-  if (data.get("/controlState")) {
+  if (data.get(prefix + "/controlState")) {
     Serial.print("Control state stream event type: "); Serial.println(data.eventType.c_str());
     Serial.printf("Value %s (%ld)\n", data.value.c_str(), data.value.toInt());
-    controlState = (ControlState)data.value.toInt();
+    zone->setControlState((ControlState)data.value.toInt());
+  }
+  if (data.get(prefix + "/profile")) {
+    Serial.printf("Profile %s\n", data.value.c_str());
+    if (data.value.toInt()) {
+      zone->startProfile();
+    } else {
+      zone->stopProfile();
+    }
+  }
+}
+
+void streamCallback(MultiPathStream data) {
+  Serial.println("Got stream data");
+  telemetry.burst();
+  readZoneInputs(data, zones[0], "");
+  for (uint8_t i = 0; i < nZones; i++) {
+    readZoneInputs(data, zones[i], "/zones/" + String(i));
+  }
+  if (data.get("/ssrMode")) {
+    Serial.printf("SSR mode %s\n", data.value.c_str());
+    SsrTimer::setMode(data.value.toInt() == SSR_MODE_SIGMA_DELTA ? SSR_MODE_SIGMA_DELTA
+                                                                 : SSR_MODE_WINDOW);
   }
   Serial.println(data.value.c_str());
-  Serial.printf("After stream data update: setpoint %f control state %d\n", setPoint, controlState);
+  for (uint8_t i = 0; i < nZones; i++) {
+    Serial.printf("After stream data update: %s setpoint %f control state %d\n", zones[i]->name(),
+                  zones[i]->targetTemp(), zones[i]->state());
+  }
   Serial.printf("Received stream payload size: %d (Max. %d)\n\n", data.payloadLength(), data.maxPayloadLength());
 }
 
@@ -488,8 +548,8 @@ void startFirebase(String &idToken) {
 
 void waitForFirebase(Adafruit_ILI9341 &tft) {
   Serial.println("Waiting for Firebase...");
-  fbLoopMillis = millis();
-  while(millis() < fbLoopMillis + FIREBASE_BEGIN_WAIT_MILLIS) {
+  unsigned long fbLoopMillis = millis();
+  while(millis() - fbLoopMillis < FIREBASE_BEGIN_WAIT_MILLIS) {
     if (Firebase.ready()) {
       Serial.println("Ready!");
       break;
@@ -517,9 +577,22 @@ void verifyAuthentication(Adafruit_ILI9341 &tft) {
   }
 }
 
-// Initialization
+// Clear the screen for the running stats, which then have to be redrawn in
+// full. The clearing itself is done by renderStep().
 
-void setup() {
+void clearStats() {
+  clearBands = CLEAR_BANDS;
+  headerField.invalidate();
+  powerField.invalidate();
+  tempLabelField.invalidate();
+  tempField.invalidate();
+  rateField.invalidate();
+}
+
+// Initialization. Returns early, in a mode other than AUTHENTICATED_CLIENT,
+// if the board can't get online.
+
+void startup() {
 
   // Wait for... ?
 
@@ -530,9 +603,9 @@ void setup() {
   Serial.begin(115200);
   Serial.println("--- Kettle OS ---");
 
-  // Set up SPI frequency
+  // Register the devices sharing the SPI bus with their own clocks
 
-  SPI.setFrequency(ESP_SPI_FREQ);
+  touchSpi = SpiBus::addDevice(TOUCH_CS, TOUCH_SPI_FREQ, SPI_MODE0);
 
   // Mount SPI filesystem
 
@@ -540,20 +613,38 @@ void setup() {
     Serial.println("ERROR: Unable to mount filesystem");
   }
 
-  // Initialize digital pins as outputs
-
-  pinMode(LED_BUILTIN, OUTPUT);
-  pinMode(ssrPin, OUTPUT);
-  pinMode(rtdPin, OUTPUT);
+  // Set up the zones, with their RTD conversions spread over the sample
+  // period, and start the SSR cycles, off until there are on times
+
+  ZoneConfig zoneConfigs[ZONES_MAX];
+  float budgetAmps;
+  nZones = Zone::loadConfig(ZONES_FILE, zoneConfigs, budgetAmps);
+  for (uint8_t i = 0; i < nZones; i++) {
+    Serial.printf("Zone %d: %s, RTD CS %d, SSR pin %d\n", i, zoneConfigs[i].name,
+                  zoneConfigs[i].rtdCs, zoneConfigs[i].ssrPin);
+    zones[i] = new Zone(i, zoneConfigs[i]);
+    zones[i]->begin(SSR_MAINS_HZ == 60 ? RTD_FILTER_60HZ : RTD_FILTER_50HZ, RTD_SAMPLE_TIME,
+                    RTD_SAMPLE_TIME * i / nZones);
+    trendCharts[i] = new TrendChart();
+  }
+  if (budgetAmps > 0) {
+    Serial.printf("SSR current budget %.1f A\n", budgetAmps);
+    SsrTimer::setBudget(budgetAmps);
+  }
+  SsrTimer::begin(SSR_CYCLE_TIME);
 
   // Set unique board ID to wifi MAC address
 
   boardID = WiFi.macAddress();
+  boardPath = "/" + boardID;
 
   // Configure screen
 
   tft.begin();
-  touch.begin(tft.width(), tft.height());  // Must be done before setting rotation
+  if (SpiBus::acquire(touchSpi)) {
+    touch.begin(tft.width(), tft.height());  // Must be done before setting rotation
+    SpiBus::release(touchSpi);
+  }
   Serial.print("tftx = ");
   Serial.print(tft.width());
   Serial.print(" tfty = ");
@@ -568,12 +659,6 @@ void setup() {
   // 1768
   touch.setCalibration(1816, 281, 262, 1768);
 
-  // Connect to RTD probe and configure PID
-
-  thermo.begin(MAX31865_3WIRE);
-  tempPID.SetOutputLimits(0, SSR_CYCLE_TIME);
-  tempPID.SetMode(AUTOMATIC);
-
   // Check for WiFi details file.
   // If not found, start in access point mode
   // Otherwise, try to connect
@@ -605,145 +690,258 @@ void setup() {
   verifyAuthentication(tft);
   if (mode == AUTH_EXPIRED || mode == DISCONNECTED) return;
 
-  // Prepare for first cycle for SSR loop and DB loop
-
-  ssrMillis = millis() - SSR_CYCLE_TIME;
-  dataMillis = millis() - DB_UPDATE_CYCLE_TIME;
-  tft.fillScreen(ILI9341_BLACK);
+  clearStats();
 }
 
-void showStats(float pot, float temp, uint8_t fault) {
-  float level = (pot - 10) / 100;
-  if (level < 0) level = 0;
-  if (level > 10) level = 10;
+// Draw one of the STATS_FIELDS fields of the running stats
+
+// Rate of rise and, under PID control, time to the set point, or what is
+// wrong with the probe
+
+void showRateField(Zone *zone) {
+  char buf[40];
+  const TempEstimator &estimator = zone->estimator();
+  switch (estimator.check()) {
+    case PROBE_OUT_OF_RANGE:
+      sprintf(buf, " Probe out of range ");
+      break;
+    case PROBE_JUMP:
+      sprintf(buf, " Probe reading jumped ");
+      break;
+    case PROBE_STUCK:
+      sprintf(buf, " Probe not responding ");
+      break;
+    default:
+      float seconds = estimator.secondsTo(zone->targetTemp());
+      int len = sprintf(buf, " %+.1f C/min ", estimator.rate() * 60);
+      if (zone->state() == CONTROL_PID && !isnan(seconds) && seconds < 6000) {
+        sprintf(buf + len, " ETA %2d:%02d ", (int) seconds / 60, (int) seconds % 60);
+      } else if (zone->state() == CONTROL_PID) {
+        sprintf(buf + len, " ETA --:-- ");
+      }
+      break;
+  }
+  rateField.draw(&tft, buf);
+}
 
+void showStatsField(uint8_t field, Zone *zone, float pot) {
   char buf[80];
-  tft.setTextColor(ILI9341_GREEN, ILI9341_BLACK);
-  tft.setTextSize(2);
-  if (controlState == CONTROL_MANUAL || controlState == CONTROL_OFF) {
-    sprintf(buf, " Manual Heat Control ");
-  } else {
-    sprintf(buf, "  Auto Heat Control  ");
+  ControlState controlState = zone->state();
+  switch (field) {
+    case 0:
+      if (controlState == CONTROL_MANUAL || controlState == CONTROL_OFF) {
+        sprintf(buf, " Manual Heat Control ");
+      } else if (controlState == CONTROL_AUTOTUNE) {
+        sprintf(buf, "  Autotune, cycle %d  ", zone->autotuneCycles());
+      } else if (zone->profile().running()) {
+        const Profile &profile = zone->profile();
+        int32_t seconds = profile.remaining();
+        sprintf(buf, " %.8s %d/%d %s%d:%02d ", profile.stepName(), profile.step() + 1,
+                profile.steps(), profile.state() == PROFILE_HOLD ? "" : "+",
+                (int) seconds / 60, (int) seconds % 60);
+      } else if (zone->boiling()) {
+        sprintf(buf, "        Boil         ");
+      } else {
+        sprintf(buf, "  Auto Heat Control  ");
+      }
+      headerField.draw(&tft, buf);
+      break;
+    case 1:
+      if (controlState == CONTROL_MANUAL || controlState == CONTROL_OFF) {
+        float level = (pot - 10) / 100;
+        if (level < 0) level = 0;
+        if (level > 10) level = 10;
+        sprintf(buf, " %2.2f ", level);
+      } else {
+        sprintf(buf, " %2.2f ", zone->output() / SSR_CYCLE_TIME * 10);
+      }
+      powerField.draw(&tft, buf);
+      break;
+    case 2:
+      if (nZones > 1) {
+        sprintf(buf, " %s Temperature ", zone->name());
+        tempLabelField.draw(&tft, buf);
+      } else {
+        tempLabelField.draw(&tft, "Current Temperature");
+      }
+      break;
+    case 3:
+      if (zone->fault() || zone->estimator().check() != PROBE_OK) {
+        sprintf(buf, " FAULT ");
+      } else {
+        sprintf(buf, "  %3.1f  ", zone->temperature());
+      }
+      tempField.draw(&tft, buf);
+      break;
+    case 4:
+      showRateField(zone);
+      break;
   }
-  Util::drawCenteredString(&tft, buf, 160, 20);
+}
 
-  tft.setTextSize(4);
-  if (controlState == CONTROL_MANUAL || controlState == CONTROL_OFF) {
-    sprintf(buf, " %2.2f ", level);
-  } else {
-    sprintf(buf, " %2.2f ", pidOut / SSR_CYCLE_TIME * 10);
+// Do the next step of pending display work. Returns false if there was none.
+
+bool renderStep() {
+  if (clearBands) {
+    int16_t h = tft.height() / CLEAR_BANDS;
+    tft.fillRect(0, (CLEAR_BANDS - clearBands) * h, tft.width(), h, ILI9341_BLACK);
+    clearBands--;
+    return true;
+  }
+  if (screen == SCREEN_CHART) {
+    return trendCharts[shownZone]->drawMore(&tft, CHART_COLUMNS_PER_STEP);
+  }
+  if (statsFields) {
+    showStatsField(STATS_FIELDS - statsFields, zones[shownZone], sensorValue);
+    statsFields--;
+    return true;
   }
-  Util::drawCenteredString(&tft, buf, 160, 60);
- 
-  tft.setTextSize(2);
-  sprintf(buf, "Current Temperature");
-  Util::drawCenteredString(&tft, buf, 160, 120);
+  return false;
+}
 
-  tft.setTextSize(4);
-  if (fault) {
-    sprintf(buf, " FAULT ");
+// Switch from the stats of a zone to its trend chart, and from the chart to
+// the stats of the next zone
+
+void nextScreen() {
+  if (screen == SCREEN_STATS) {
+    clearBands = 0;
+    statsFields = 0;
+    trendCharts[shownZone]->draw(&tft);
+    screen = SCREEN_CHART;
   } else {
-    sprintf(buf, "  %3.1f  ", temp);
+    trendCharts[shownZone]->close(&tft);
+    shownZone = (shownZone + 1) % nZones;
+    clearStats();
+    statsFields = STATS_FIELDS;
+    screen = SCREEN_STATS;
   }
-  Util::drawCenteredString(&tft, buf, 160, 160);
+}
 
-  return;
+// Tasks
+
+void ssrTask(void *ctx) {
+  for (uint8_t i = 0; i < nZones; i++) {
+    zones[i]->updateSsr(sensorValue);
+  }
+  SsrTimer::updateLeds();
 }
 
-void loop() {
-  
-  // If running web server, poll for client connections
+void sensorTask(void *ctx) {
+  if (potFilter.add(analogRead(potPin))) {
+    sensorValue = potFilter.value();
+  }
+}
 
-  if (mode == ACCESS_POINT && pServer) {
-    pServer->handleClient();
-    return;
+// Step the RTD acquisition of every zone and come back when the next step
+// of any of them is due
+
+void rtdSensorTask(void *ctx) {
+  uint32_t nextMs = UINT32_MAX;
+  for (uint8_t i = 0; i < nZones; i++) {
+    nextMs = min(nextMs, zones[i]->pollRtd());
   }
+  Scheduler::schedule(rtdTask, nextMs);
+}
 
-  // Read inputs
-
-  sensorValue = analogRead(potPin);
-  rtdTemp = thermo.temperature(RNOMINAL, RREF);
-  uint8_t fault = thermo.readFault();
-  tempPID.Compute();
-
-  // If SSR cycle time has been exceeded, start a new cycle
-
-  unsigned long now = millis();
-  if (now >= ssrMillis + SSR_CYCLE_TIME) {
-    // Start next loop
-    switch (controlState) {
-      case CONTROL_OFF:
-        timeOnMs = 0;
-        break;
-      case CONTROL_MANUAL:
-        timeOnMs = SSR_CYCLE_TIME * sensorValue / 1024;
-        break;
-      case CONTROL_PID:
-        timeOnMs = pidOut;
-        break;
-    }
-    if (timeOnMs < 100) {
-      timeOnMs = 0;
-    }
-    if (timeOnMs > SSR_CYCLE_TIME) {
-      timeOnMs = SSR_CYCLE_TIME;
-    }
-    ssrMillis += SSR_CYCLE_TIME;
+// Run the controllers. A zone whose autotune has ended gets its stats
+// redrawn, if shown, to pick up the new control state.
+
+void pidTask(void *ctx) {
+  for (uint8_t i = 0; i < nZones; i++) {
+    if (zones[i]->control() && i == shownZone) statsFields = STATS_FIELDS;
   }
+}
 
-  // Turn on SSR if it's under control and we're in the ON cycle
+// Record a trend sample for each zone
 
-  if (controlState != CONTROL_OFF && timeOnMs > now - ssrMillis) {
-    digitalWrite(ssrPin, HIGH);
-    digitalWrite(LED_BUILTIN, LOW);
-  } else {
-    digitalWrite(ssrPin, LOW);
-    digitalWrite(LED_BUILTIN, HIGH);
+void trendTask(void *ctx) {
+  for (uint8_t i = 0; i < nZones; i++) {
+    Zone *zone = zones[i];
+    trendCharts[i]->addSample(zone->fault() ? NAN : zone->temperature(), zone->targetTemp(),
+                              (float) zone->onTime() / SSR_CYCLE_TIME);
   }
+  if (mode == AUTHENTICATED_CLIENT && screen == SCREEN_CHART) {
+    trendCharts[shownZone]->drawLatest(&tft);
+  }
+}
 
-  // Update display if it's time
+// Refresh the running stats
 
-  if (millis() > displayMillis + DISPLAY_CYCLE_TIME) {
-    displayMillis += DISPLAY_CYCLE_TIME;
-    if (mode == AUTHENTICATED_CLIENT) {
-      showStats(sensorValue, rtdTemp, fault);
-    }
+void statsTask(void *ctx) {
+  if (mode == AUTHENTICATED_CLIENT && screen == SCREEN_STATS) {
+    statsFields = STATS_FIELDS;
   }
+}
 
-  // Write state to Firebase if it's time
+// Do as much pending display work as fits in the budget
 
-  if (mode == AUTHENTICATED_CLIENT && Firebase.ready() &&
-      millis() > dataMillis + DB_UPDATE_CYCLE_TIME)
-  {
-    dataMillis += DB_UPDATE_CYCLE_TIME;
-    Serial.printf("Setting pot sensor val %d\n", sensorValue);
-    bool ok = Firebase.RTDB.setIntAsync(&fbdoWrite, "/" + boardID + "/sensors/pot", sensorValue);
-    if (!ok) {
-      Serial.printf("Problem writing pot sensor val: %s\n", fbdoWrite.errorReason().c_str());
-    }
-    if (fault) {
-      Serial.printf("RTD probe fault 0x%x -- check connection -- ", fault);
-      thermo.clearFault();
-    }
-    Serial.printf("Setting temperature sensor val %f\n", rtdTemp);
-    ok = Firebase.RTDB.setFloatAsync(&fbdoWrite, "/" + boardID + "/sensors/temp", (float)rtdTemp);
-    if (!ok) {
-      Serial.printf("Problem writing temp sensor val: %s\n", fbdoWrite.errorReason().c_str());
-    }
-    float power = (float) timeOnMs / SSR_CYCLE_TIME;
-    Serial.printf("Setting output power %f\n", power);
-    ok = Firebase.RTDB.setFloatAsync(&fbdoWrite, "/" + boardID + "/output", power);
-    if (!ok) {
-      Serial.printf("Problem writing power: %s\n", fbdoWrite.errorReason().c_str());
+void renderTask(void *ctx) {
+  unsigned long renderStart = micros();
+  while (micros() - renderStart < RENDER_BUDGET_US) {
+    if (!renderStep()) break;
+  }
+}
+
+// Publish what changed to Firebase in one update: the pot for the board,
+// and per zone under /zones/<n> the temperature, output, set point, control
+// state, PID output, feedforward and error, and the profile
+
+void telemetryTask(void *ctx) {
+  if (mode != AUTHENTICATED_CLIENT || !Firebase.ready()) return;
+  for (uint8_t i = 0; i < nZones; i++) {
+    ProfileState state = zones[i]->profile().state();
+    if (state == PROFILE_RAMP || state == PROFILE_WAIT) telemetry.burst();
+  }
+  if (!telemetry.begin()) return;
+  telemetry.add(-1, "sensors/pot", sensorValue, TELEMETRY_POT_DEADBAND, 0);
+  for (uint8_t i = 0; i < nZones; i++) {
+    Zone *zone = zones[i];
+    const Profile &profile = zone->profile();
+    telemetry.add(i, "sensors/temp", zone->temperature(), TELEMETRY_TEMP_DEADBAND, 2);
+    telemetry.add(i, "sensors/fault", zone->fault(), 0, 0);
+    telemetry.add(i, "output", (float) zone->onTime() / SSR_CYCLE_TIME,
+                  TELEMETRY_OUTPUT_DEADBAND, 3);
+    telemetry.add(i, "setPoint", zone->targetTemp(), TELEMETRY_SETPOINT_DEADBAND, 2);
+    telemetry.add(i, "controlState", zone->state(), 0, 0);
+    telemetry.add(i, "profile/state", profile.state(), 0, 0);
+    telemetry.add(i, "profile/step", profile.step() + 1, 0, 0);
+    telemetry.add(i, "profile/steps", profile.steps(), 0, 0);
+    telemetry.addText(i, "profile/name", profile.stepName());
+    telemetry.add(i, "profile/remaining", profile.remaining(), TELEMETRY_REMAINING_DEADBAND, 0);
+  }
+  for (uint8_t i = 0; i < nZones; i++) {
+    Zone *zone = zones[i];
+    telemetry.addDetail(i, "pid/out", zone->pidOutput(), 1);
+    telemetry.addDetail(i, "pid/ff", zone->feedForwardOutput(), 1);
+    telemetry.addDetail(i, "pid/error", zone->targetTemp() - zone->estimator().temperature(), 3);
+  }
+  if (!telemetry.end()) return;
+  for (uint8_t i = 0; i < nZones; i++) {
+    Zone *zone = zones[i];
+    if (zone->fault()) {
+      Serial.printf("%s: RTD probe fault 0x%x -- check connection\n", zone->name(), zone->fault());
     }
-    Serial.printf("Temp PID temp %f out %f set %f\n", rtdTemp, pidOut, setPoint);
+    Serial.printf("%s: temp %.2f estimate %.2f set %.2f out %.0f ff %.0f, %+.1f C/min, probe %d\n",
+                  zone->name(), zone->temperature(), zone->estimator().temperature(),
+                  zone->targetTemp(), zone->pidOutput(), zone->feedForwardOutput(),
+                  zone->estimator().rate() * 60, zone->estimator().check());
+  }
+  if (!Firebase.RTDB.updateNodeAsync(&fbdoWrite, boardPath, &telemetry.json())) {
+    Serial.printf("Problem writing telemetry: %s\n", fbdoWrite.errorReason().c_str());
+    return;
   }
+  telemetry.commit();
+}
 
-  // Check touch screen
+// Check touch screen and buttons
 
-  uint16_t x, y;
-  if (touch.isTouching()) {
+void touchTask(void *ctx) {
+  uint16_t x = 0, y = 0;
+  bool touching = touch.isTouching();
+  if (touching) {
+    if (!SpiBus::acquire(touchSpi)) return;
     touch.getPosition(x, y);
+    SpiBus::release(touchSpi);
     if (mode == NO_WIFI || mode == REGISTRATION_SENT ||
         mode == NO_CERTS || mode == NO_FB_CONFIG || mode == REGISTRATION_ERROR ||
         mode == REGISTRATION_EXPIRED || mode == DISCONNECTED || mode == AUTH_EXPIRED) {
@@ -755,54 +953,89 @@ void loop() {
     Serial.printf("Touch at %d, %d\n", x, y);
   }
 
-  // Check if a button is pressed
+  // A new touch on the running screen moves on to the next screen
 
-  for (uint8_t b=0; b<nButtons; b++) {
-    if (buttons[b].contains(x, y)) {
-      buttons[b].press(true);  // tell the button it is pressed
-    } else {
-      buttons[b].press(false);  // tell the button it is NOT pressed
+  if (mode == AUTHENTICATED_CLIENT && touching && !wasTouching) {
+    nextScreen();
+  }
+  wasTouching = touching;
+
+  // Check if a button is pressed, redrawing buttons as they change
+
+  int8_t b = buttons.update(&tft, touching, x, y);
+  if (b >= 0) {
+    if (mode == NO_WIFI) {
+      if (b == 0) {
+        // Continue
+        buttons.clear();
+        tft.fillScreen(ILI9341_BLACK);
+        drawDisconnected();
+        mode = DISCONNECTED;
+      } else {
+        // Reset configuration
+        LittleFS.remove(WIFI_PARAM_FILE);
+        ESP.reset();
+      }
+    } else if (mode == REGISTRATION_SENT || mode == REGISTRATION_ERROR ||
+               mode == REGISTRATION_EXPIRED || mode == AUTH_EXPIRED) {
+      if (b == 0) {
+        // Continue
+        buttons.clear();
+        tft.fillScreen(ILI9341_BLACK);
+        drawDisconnected();
+        mode = DISCONNECTED;
+      } else if (b == 1) {
+        // Retry
+        ESP.reset();
+      } else {
+        // Reset configuration
+        LittleFS.remove(DEVICE_REG_TOKEN_FILE);
+        LittleFS.remove(ID_TOKEN_FILE);
+        ESP.reset();
+      }
     }
   }
+}
 
-  // Process button state changes
+// Report where loop time went
 
-  for (uint8_t b=0; b<MAX_BUTTONS; b++) {
-    if (buttons[b].justReleased()) {
-      buttons[b].drawButton();  // draw normal
-    }
-    if (buttons[b].justPressed()) {
-      // Draw inverted
-      buttons[b].drawButton(true);
-      if (mode == NO_WIFI) {
-        if (b == 0) {
-          // Continue
-          tft.fillScreen(ILI9341_BLACK);
-          drawDisconnected();
-          mode = DISCONNECTED;
-        } else {
-          // Reset configuration
-          LittleFS.remove(WIFI_PARAM_FILE);
-          ESP.reset();
-        }
-      } else if (mode == REGISTRATION_SENT || mode == REGISTRATION_ERROR ||
-                 mode == REGISTRATION_EXPIRED || mode == AUTH_EXPIRED) {
-        if (b == 0) {
-          // Continue
-          tft.fillScreen(ILI9341_BLACK);
-          drawDisconnected();
-          mode = DISCONNECTED;
-        } else if (b == 1) {
-          // Retry
-          ESP.reset();
-        } else {
-          // Reset configuration
-          LittleFS.remove(DEVICE_REG_TOKEN_FILE);
-          LittleFS.remove(ID_TOKEN_FILE);
-          ESP.reset();
-        }
-      }        
-      delay(100); // UI debouncing
-    }
+void schedulerStatsTask(void *ctx) {
+  Scheduler::printStats(Serial);
+  Scheduler::resetStats();
+  Serial.printf("Telemetry: %lu updates, %lu values sent, %lu suppressed\n",
+                (unsigned long) telemetry.updates(), (unsigned long) telemetry.sent(),
+                (unsigned long) telemetry.suppressed());
+}
+
+void setup() {
+  startup();
+
+  // Tasks start once setup is done, so the time it took doesn't count as
+  // overruns
+
+  Scheduler::addTask("ssr", ssrTask, NULL, SSR_UPDATE_TIME, PRIORITY_SSR);
+  Scheduler::addTask("sensors", sensorTask, NULL, SENSOR_READ_TIME, PRIORITY_SENSORS);
+  rtdTask = Scheduler::addTask("rtd", rtdSensorTask, NULL, 0, PRIORITY_SENSORS);
+  Scheduler::addTask("pid", pidTask, NULL, PID_POLL_TIME, PRIORITY_PID);
+  Scheduler::addTask("touch", touchTask, NULL, TOUCH_POLL_TIME, PRIORITY_TOUCH);
+  Scheduler::addTask("trend", trendTask, NULL, TREND_SAMPLE_TIME, PRIORITY_DISPLAY,
+                     RTD_SAMPLE_TIME);
+  Scheduler::addTask("stats", statsTask, NULL, DISPLAY_CYCLE_TIME, PRIORITY_DISPLAY);
+  Scheduler::addTask("render", renderTask, NULL, RENDER_TIME, PRIORITY_DISPLAY);
+  Scheduler::addTask("telemetry", telemetryTask, NULL, TELEMETRY_BURST_INTERVAL, PRIORITY_TELEMETRY);
+  Scheduler::addTask("scheduler", schedulerStatsTask, NULL, SCHEDULER_STATS_TIME,
+                     PRIORITY_STATS, SCHEDULER_STATS_TIME);
+  Scheduler::resetStats();
+}
+
+void loop() {
+  
+  // If running web server, poll for client connections
+
+  if (mode == ACCESS_POINT && pServer) {
+    pServer->handleClient();
+    return;
   }
+
+  Scheduler::run();
 }
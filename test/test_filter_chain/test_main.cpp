@@ -0,0 +1,115 @@
+// Step response of FilterChain in the configurations the firmware uses, and
+// its cost per sample on the host. Run with:
+// pio test -e native -f test_filter_chain
+
+#include <Arduino.h>
+#include <chrono>
+#include <unity.h>
+#include "FilterChain.h"
+
+#define BENCH_SAMPLES 50000000
+
+void setUp() {}
+void tearDown() {}
+
+// RTD chain, 0.01 C units at 10 Hz: median of 3, IIR shift 2. A step from
+// 20 to 30 C carrying a 99.99 C glitch never shows the glitch, passes 63%
+// of the step within 5 samples, rises without overshoot and settles to the
+// new value.
+
+void testRtdStep() {
+  FilterChain filter(1, 3, 2);
+  for (uint8_t i = 0; i < 5; i++) filter.add(2000);
+  TEST_ASSERT_EQUAL_INT32(2000, filter.value());
+
+  int32_t last = filter.value();
+  int8_t reached = -1;
+  for (uint8_t i = 0; i < 40; i++) {
+    TEST_ASSERT_TRUE(filter.add(i == 3 ? 9999 : 3000));
+    int32_t v = filter.value();
+    TEST_ASSERT_GREATER_OR_EQUAL_INT32(last, v);
+    TEST_ASSERT_LESS_OR_EQUAL_INT32(3000, v);
+    if (reached < 0 && v >= 2632) reached = i + 1;
+    last = v;
+  }
+  TEST_ASSERT_TRUE(reached > 0);
+  TEST_ASSERT_LESS_OR_EQUAL_INT32(5, reached);
+  TEST_ASSERT_EQUAL_INT32(3000, last);
+}
+
+// Pot chain, 40 Hz: averages of 4, median of 3, IIR shift 1. One value per
+// 4 samples, the first one following the first group at once, and a step
+// settles to within 2 counts in 10 values.
+
+void testPotStep() {
+  FilterChain filter(4, 3, 1);
+  TEST_ASSERT_FALSE(filter.valid());
+  uint8_t values = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (filter.add(100)) values++;
+  }
+  TEST_ASSERT_EQUAL_INT32(1, values);
+  TEST_ASSERT_TRUE(filter.valid());
+  TEST_ASSERT_EQUAL_INT32(100, filter.value());
+
+  values = 0;
+  for (uint8_t i = 0; i < 40; i++) {
+    if (filter.add(900)) values++;
+  }
+  TEST_ASSERT_EQUAL_INT32(10, values);
+  TEST_ASSERT_INT32_WITHIN(2, 900, filter.value());
+}
+
+// Small steps aren't lost in the IIR, and negative values round the same way
+// as positive ones
+
+void testResolution() {
+  FilterChain up(1, 1, 4), down(1, 1, 4);
+  up.add(0);
+  down.add(0);
+  for (uint8_t i = 0; i < 200; i++) {
+    up.add(1);
+    down.add(-1);
+  }
+  TEST_ASSERT_EQUAL_INT32(1, up.value());
+  TEST_ASSERT_EQUAL_INT32(-1, down.value());
+}
+
+// reset() forgets the history, so the next group passes straight through
+
+void testReset() {
+  FilterChain filter(1, 3, 2);
+  for (uint8_t i = 0; i < 10; i++) filter.add(2000);
+  filter.reset();
+  TEST_ASSERT_FALSE(filter.valid());
+  filter.add(500);
+  TEST_ASSERT_EQUAL_INT32(500, filter.value());
+}
+
+// Time per sample through the RTD chain, reported rather than checked
+
+void benchmarkRtdChain() {
+  FilterChain filter(1, 3, 2);
+  volatile int32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+    filter.add(i & 1023);
+    sink = filter.value();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  char message[64];
+  snprintf(message, sizeof(message), "%.1f ns per sample",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_SAMPLES);
+  TEST_MESSAGE(message);
+  (void) sink;
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(testRtdStep);
+  RUN_TEST(testPotStep);
+  RUN_TEST(testResolution);
+  RUN_TEST(testReset);
+  RUN_TEST(benchmarkRtdChain);
+  return UNITY_END();
+}
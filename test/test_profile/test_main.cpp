@@ -0,0 +1,95 @@
+// Profile loading from LittleFS, on the native HAL with the filesystem in a
+// temporary directory: a load that fails leaves a running profile alone,
+// and a negative hold counts as none. Run with:
+// pio test -e native -f test_profile
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <stdlib.h>
+#include <unity.h>
+#include "Hal.h"
+#include "Profile.h"
+
+static void wait(uint32_t ms) {
+  HalClock::advance((uint64_t) ms * 1000000);
+}
+
+static void writeFile(const char *path, const char *text) {
+  File f = LittleFS.open(path, "w");
+  f.print(text);
+  f.close();
+}
+
+void setUp() {
+  writeFile("/mash.json",
+            "{\"steps\": [{\"name\": \"Mash\", \"target\": 66, \"hold\": 60},"
+            "{\"name\": \"Mash out\", \"target\": 76, \"hold\": 10}]}");
+}
+
+void tearDown() {}
+
+// A missing file or one without steps doesn't stop the profile or change
+// its steps
+
+void testFailedLoadKeepsProfile() {
+  Profile profile;
+  TEST_ASSERT_TRUE(profile.load("/mash.json"));
+  profile.start(20);
+  TEST_ASSERT_EQUAL(PROFILE_WAIT, profile.state());
+
+  TEST_ASSERT_FALSE(profile.load("/missing.json"));
+  writeFile("/empty.json", "{\"steps\": []}");
+  TEST_ASSERT_FALSE(profile.load("/empty.json"));
+  TEST_ASSERT_EQUAL(PROFILE_WAIT, profile.state());
+  TEST_ASSERT_EQUAL(2, profile.steps());
+  TEST_ASSERT_TRUE(strcmp(profile.stepName(), "Mash") == 0);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 66, profile.update(66));
+  TEST_ASSERT_EQUAL(PROFILE_HOLD, profile.state());
+}
+
+// Loading another profile stops the one running and starts from its first
+// step
+
+void testLoadStops() {
+  Profile profile;
+  profile.load("/mash.json");
+  profile.start(20);
+  profile.update(66);
+  wait(60 * 60000);
+  profile.update(66);
+  TEST_ASSERT_EQUAL(1, profile.step());
+
+  writeFile("/single.json", "{\"steps\": [{\"name\": \"Boil\", \"target\": 100, \"hold\": 5}]}");
+  TEST_ASSERT_TRUE(profile.load("/single.json"));
+  TEST_ASSERT_EQUAL(PROFILE_IDLE, profile.state());
+  TEST_ASSERT_EQUAL(0, profile.step());
+  TEST_ASSERT_EQUAL(1, profile.steps());
+  TEST_ASSERT_TRUE(strcmp(profile.stepName(), "Boil") == 0);
+}
+
+// A negative hold ends the step as soon as the temperature is reached
+
+void testNegativeHold() {
+  writeFile("/negative.json",
+            "{\"steps\": [{\"target\": 66, \"hold\": -5}, {\"target\": 76, \"hold\": 10}]}");
+  Profile profile;
+  TEST_ASSERT_TRUE(profile.load("/negative.json"));
+  profile.start(20);
+  TEST_ASSERT_EQUAL_INT32(0, profile.remaining());
+  profile.update(66);
+  TEST_ASSERT_EQUAL(PROFILE_HOLD, profile.state());
+  profile.update(66);
+  TEST_ASSERT_EQUAL(1, profile.step());
+  TEST_ASSERT_EQUAL_INT32(600, profile.remaining());
+}
+
+int main(int argc, char **argv) {
+  char dir[] = "/tmp/test_profile.XXXXXX";
+  HalFs::setRoot(mkdtemp(dir));
+  UNITY_BEGIN();
+  RUN_TEST(testFailedLoadKeepsProfile);
+  RUN_TEST(testLoadStops);
+  RUN_TEST(testNegativeHold);
+  return UNITY_END();
+}
@@ -0,0 +1,76 @@
+// RtdConverter against the library's floating point conversion, for the
+// probe and reference resistor fitted to the board, and the cost of each on
+// the host. Run with: pio test -e native -f test_rtd_converter
+
+#include <Arduino.h>
+#include <chrono>
+#include <unity.h>
+#include "RtdConverter.h"
+
+#define RREF 430.0
+#define RNOMINAL 100.0
+#define BENCH_READINGS 20000000
+
+Adafruit_MAX31865 thermo(16);
+RtdConverter converter;
+
+void setUp() {}
+void tearDown() {}
+
+// Every code from -50 to 300 C reads within 0.011 C of the library: the
+// 0.01 C output step plus float rounding in the reference
+
+void testAccuracy() {
+  uint32_t n = 0;
+  for (uint32_t code = 0; code < 0x8000; code++) {
+    float expected = thermo.calculateTemperature(code, RNOMINAL, RREF);
+    if (isnan(expected) || expected < -50 || expected > 300) continue;
+    TEST_ASSERT_FLOAT_WITHIN(0.011, expected, converter.centiDegrees(code) / 100.0);
+    n++;
+  }
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(10000, n);
+}
+
+// Readings never go down as the code goes up, across the table nodes too
+
+void testMonotonic() {
+  int32_t last = converter.centiDegrees(0);
+  for (uint32_t code = 1; code < 0x8000; code++) {
+    int32_t t = converter.centiDegrees(code);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT32(last, t);
+    last = t;
+  }
+}
+
+// Time per reading over the codes of 0 to 100 C. Reported rather than
+// checked, as the host has a hardware FPU and the ESP8266 doesn't.
+
+void benchmarkConversion() {
+  volatile float sinkFloat = 0;
+  volatile int32_t sinkTable = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_READINGS; i++) {
+    sinkFloat = thermo.calculateTemperature(7620 + (i & 0x1FFF) / 2, RNOMINAL, RREF);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_READINGS; i++) {
+    sinkTable = converter.centiDegrees(7620 + (i & 0x1FFF) / 2);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  char message[80];
+  snprintf(message, sizeof(message), "calculateTemperature %.1f ns, centiDegrees %.1f ns",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_READINGS,
+           std::chrono::duration<double, std::nano>(t2 - t1).count() / BENCH_READINGS);
+  TEST_MESSAGE(message);
+  (void) sinkFloat;
+  (void) sinkTable;
+}
+
+int main(int argc, char **argv) {
+  converter.begin(thermo, RNOMINAL, RREF);
+  UNITY_BEGIN();
+  RUN_TEST(testAccuracy);
+  RUN_TEST(testMonotonic);
+  RUN_TEST(benchmarkConversion);
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+// The setup screens drawn on the ILI9341 model, each compared with a
+// checksum of a known good rendering. The glyphs come from the GFX library's
+// font, so the checksum leaves out the text: every character of the classic
+// font fills a cell of 6x8 pixels times the text size, whatever the font,
+// and the cells of each string are masked. Within them the text must be in
+// its colours, over its background, and not blank. After a deliberate
+// change to a screen, check it with --screenshot in the native build and
+// update its checksum here. Run with: pio test -e native -f test_screens
+
+#include <Arduino.h>
+#include <unity.h>
+#include <Adafruit_ILI9341esp.h>
+#include "Hal.h"
+#include "SimIli9341.h"
+#include "Util.h"
+
+#define TFT_DC 2
+#define TFT_CS 15
+
+#define LOGO_CHECKSUM 0x0a61e475
+#define NO_WIFI_CHECKSUM 0x56aacfa5
+#define NEED_SETUP_CHECKSUM 0x94d75abd
+
+// From main.cpp
+
+extern Adafruit_ILI9341 tft;
+void drawNoWifi(Adafruit_ILI9341 &tft);
+void drawNeedSetupScreen(Adafruit_ILI9341 &tft, String message, String label0, String label1,
+                         String label2);
+
+static SimIli9341 panel(TFT_DC);
+
+// The cells of a string, with its colours
+
+struct TextBox {
+  int16_t x, y, w, h;
+  uint16_t color, bg;
+};
+
+#define MAX_BOXES 8
+
+static TextBox boxes[MAX_BOXES];
+static uint8_t nBoxes;
+
+static void addBox(int16_t x, int16_t y, const char *text, uint8_t size, uint16_t color,
+                   uint16_t bg) {
+  boxes[nBoxes++] = { x, y, (int16_t) (strlen(text) * 6 * size), (int16_t) (8 * size), color, bg };
+}
+
+// Text placed by Util::drawCenteredString()
+
+static void addCentered(int16_t x, int16_t y, const char *text, uint8_t size, uint16_t color,
+                        uint16_t bg) {
+  addBox(x - strlen(text) * 3 * size, y, text, size, color, bg);
+}
+
+// The label of a button added to a ButtonPanel centered on x, y, placed
+// within the button as ButtonPanel::add() does
+
+static void addLabel(int16_t x, int16_t y, int16_t w, int16_t h, const char *text, uint8_t size,
+                     uint16_t color, uint16_t fill) {
+  int16_t left = x - w / 2, top = y - h / 2;
+  addBox(left + w / 2 - strlen(text) * 3 * size, top + h / 2 - 4 * size, text, size, color, fill);
+}
+
+static void addLogo() {
+  addCentered(160, 25, "-- Kettle OS --", 3, ILI9341_MAGENTA, ILI9341_DARKGREEN);
+}
+
+static const TextBox *boxAt(int16_t x, int16_t y) {
+  for (uint8_t i = 0; i < nBoxes; i++) {
+    const TextBox &b = boxes[i];
+    if (x >= b.x && x < b.x + b.w && y >= b.y && y < b.y + b.h) return &b;
+  }
+  return NULL;
+}
+
+// FNV-1a over the screen as SimIli9341::checksum(), with the text cells
+// counted as one colour. Checks the text in each box on the way.
+
+static uint32_t checksum() {
+  uint32_t inked[MAX_BOXES] = { 0 };
+  uint32_t h = 2166136261u;
+  for (int16_t y = 0; y < panel.height(); y++) {
+    for (int16_t x = 0; x < panel.width(); x++) {
+      uint16_t c = panel.pixel(x, y);
+      const TextBox *box = boxAt(x, y);
+      if (box) {
+        TEST_ASSERT_TRUE(c == box->color || c == box->bg);
+        if (c == box->color) inked[box - boxes]++;
+        c = 0xFFFF;
+      }
+      h = (h ^ (c >> 8)) * 16777619u;
+      h = (h ^ (c & 0xFF)) * 16777619u;
+    }
+  }
+  for (uint8_t i = 0; i < nBoxes; i++) TEST_ASSERT_TRUE(inked[i] > 0);
+  return h;
+}
+
+static void assertChecksum(uint32_t expected, const char *screen) {
+  uint32_t actual = checksum();
+  char message[64];
+  snprintf(message, sizeof(message), "%s checksum %08x", screen, (unsigned) actual);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT32(expected, actual);
+}
+
+// Each screen is drawn over a cleared panel, as after a mode change
+
+void setUp() {
+  nBoxes = 0;
+  tft.setRotation(1);
+  tft.fillScreen(ILI9341_BLACK);
+}
+
+void tearDown() {}
+
+void testLogo() {
+  Util::drawLogo(&tft);
+  addLogo();
+  assertChecksum(LOGO_CHECKSUM, "logo");
+}
+
+void testNoWifi() {
+  drawNoWifi(tft);
+  addLogo();
+  addCentered(160, 70, "WiFi timeout", 2, ILI9341_MAGENTA, ILI9341_BLACK);
+  addLabel(80, 130, 130, 60, "Continue", 2, ILI9341_WHITE, ILI9341_GREEN);
+  addLabel(240, 130, 130, 60, "Reconfig", 2, ILI9341_WHITE, ILI9341_RED);
+  assertChecksum(NO_WIFI_CHECKSUM, "no wifi");
+}
+
+void testNeedSetup() {
+  drawNeedSetupScreen(tft, "No firebase config found", "Continue", "Retry", "Reconfig");
+  addLogo();
+  addCentered(160, 70, "No firebase config found", 2, ILI9341_MAGENTA, ILI9341_BLACK);
+  addLabel(80, 130, 130, 60, "Continue", 2, ILI9341_WHITE, ILI9341_GREEN);
+  addLabel(240, 130, 130, 60, "Retry", 2, ILI9341_WHITE, ILI9341_GREEN);
+  addLabel(160, 200, 130, 60, "Reconfig", 2, ILI9341_WHITE, ILI9341_RED);
+  assertChecksum(NEED_SETUP_CHECKSUM, "need setup");
+}
+
+int main(int argc, char **argv) {
+  HalSpi::attach(TFT_CS, &panel, "ILI9341");
+  tft.begin();
+  UNITY_BEGIN();
+  RUN_TEST(testLogo);
+  RUN_TEST(testNoWifi);
+  RUN_TEST(testNeedSetup);
+  return UNITY_END();
+}
@@ -0,0 +1,145 @@
+// SpiBus's cooperative contract with two devices on the native HAL's bus:
+// a device may nest its transactions, another one can't start while the
+// bus is held, and the chip selects are never low together. Run with:
+// pio test -e native -f test_spi_bus
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <unity.h>
+#include "Hal.h"
+#include "SpiBus.h"
+
+#define CS_A 16
+#define CS_B 4
+#define FREQ_A 5000000
+#define FREQ_B 2000000
+
+// A device that counts the times it was selected with the other one
+// selected too
+
+class FakeDevice : public SpiDevice {
+public:
+  FakeDevice *other = NULL;
+  bool selected = false;
+  uint32_t overlaps = 0;
+  void select() override {
+    selected = true;
+    if (other->selected) overlaps++;
+  }
+  void deselect() override { selected = false; }
+  uint8_t transfer(uint8_t out) override { return out; }
+};
+
+static FakeDevice fakeA, fakeB;
+static int8_t a, b;
+
+void setUp() {}
+void tearDown() {}
+
+// Select the device and clock a few bytes, the way the drivers do within
+// a transaction
+
+static void select(uint8_t cs) {
+  digitalWrite(cs, LOW);
+  for (uint8_t i = 0; i < 4; i++) SPI.transfer(0);
+}
+
+static void deselect(uint8_t cs) {
+  digitalWrite(cs, HIGH);
+}
+
+static void assertNoOverlap() {
+  TEST_ASSERT_EQUAL_UINT32(0, fakeA.overlaps + fakeB.overlaps);
+  TEST_ASSERT_EQUAL_UINT32(0, HalSpi::violations());
+}
+
+// One transaction after the other, each with its device's settings
+
+void testSequential() {
+  TEST_ASSERT_TRUE(SpiBus::acquire(a));
+  TEST_ASSERT_EQUAL_UINT32(FREQ_A, HalSpi::frequency());
+  TEST_ASSERT_EQUAL(SPI_MODE1, HalSpi::mode());
+  select(CS_A);
+  deselect(CS_A);
+  SpiBus::release(a);
+
+  TEST_ASSERT_TRUE(SpiBus::acquire(b));
+  TEST_ASSERT_EQUAL_UINT32(FREQ_B, HalSpi::frequency());
+  TEST_ASSERT_EQUAL(SPI_MODE0, HalSpi::mode());
+  select(CS_B);
+  deselect(CS_B);
+  SpiBus::release(b);
+  assertNoOverlap();
+}
+
+// A device nesting its transactions keeps the bus until the outer release,
+// and the other device can't get in between
+
+void testNested() {
+  TEST_ASSERT_TRUE(SpiBus::acquire(a));
+  select(CS_A);
+  deselect(CS_A);
+  TEST_ASSERT_TRUE(SpiBus::acquire(a));
+  select(CS_A);
+  TEST_ASSERT_FALSE(SpiBus::acquire(b));
+  deselect(CS_A);
+  SpiBus::release(a);
+  TEST_ASSERT_FALSE(SpiBus::acquire(b));
+  SpiBus::release(a);
+
+  TEST_ASSERT_TRUE(SpiBus::acquire(b));
+  select(CS_B);
+  deselect(CS_B);
+  SpiBus::release(b);
+  assertNoOverlap();
+}
+
+// Transactions of the two devices overlapping in time: the one that comes
+// second is turned away, leaves its chip select alone and gets the bus once
+// the first is done. A release by the device turned away doesn't free the
+// bus.
+
+void testOverlapping() {
+  uint32_t selectsB = HalSpi::stats(CS_B)->transactions;
+  TEST_ASSERT_TRUE(SpiBus::acquire(a));
+  select(CS_A);
+  if (SpiBus::acquire(b)) select(CS_B);
+  SpiBus::release(b);
+  TEST_ASSERT_FALSE(SpiBus::acquire(b));
+  TEST_ASSERT_EQUAL_UINT32(FREQ_A, HalSpi::frequency());
+  for (uint8_t i = 0; i < 4; i++) SPI.transfer(0);
+  deselect(CS_A);
+  SpiBus::release(a);
+
+  TEST_ASSERT_TRUE(SpiBus::acquire(b));
+  select(CS_B);
+  TEST_ASSERT_FALSE(SpiBus::acquire(a));
+  deselect(CS_B);
+  SpiBus::release(b);
+  assertNoOverlap();
+  TEST_ASSERT_EQUAL_UINT32(selectsB + 1, HalSpi::stats(CS_B)->transactions);
+}
+
+// A device that was never registered never gets the bus
+
+void testUnregistered() {
+  TEST_ASSERT_FALSE(SpiBus::acquire(-1));
+  TEST_ASSERT_FALSE(SpiBus::acquire(SPI_BUS_MAX_DEVICES));
+  TEST_ASSERT_TRUE(SpiBus::acquire(a));
+  SpiBus::release(a);
+}
+
+int main(int argc, char **argv) {
+  fakeA.other = &fakeB;
+  fakeB.other = &fakeA;
+  HalSpi::attach(CS_A, &fakeA, "A");
+  HalSpi::attach(CS_B, &fakeB, "B");
+  a = SpiBus::addDevice(CS_A, FREQ_A, SPI_MODE1);
+  b = SpiBus::addDevice(CS_B, FREQ_B, SPI_MODE0);
+  UNITY_BEGIN();
+  RUN_TEST(testSequential);
+  RUN_TEST(testNested);
+  RUN_TEST(testOverlapping);
+  RUN_TEST(testUnregistered);
+  return UNITY_END();
+}
@@ -0,0 +1,162 @@
+// SsrTimer on the native HAL's timer1 model: what onTime() reports under a
+// current budget, cutting off a channel with a sigma-delta backlog, and
+// cycles too long for the slot table at SSR_SLOT_MS. Run with:
+// pio test -e native -f test_ssr_timer
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Hal.h"
+#include "SsrTimer.h"
+
+#define CYCLE_MS 5000
+
+// Three 10 A elements, the first one with priority
+
+static const uint8_t pins[] = { 12, 13, 14 };
+static int8_t channels[3];
+
+void setUp() {
+  SsrTimer::setMode(SSR_MODE_WINDOW);
+  SsrTimer::setBudget(0);
+  SsrTimer::begin(CYCLE_MS);
+  for (uint8_t i = 0; i < 3; i++) SsrTimer::setOnTime(channels[i], 0);
+}
+
+void tearDown() {}
+
+// Run for ms in 1 ms steps. Counts the milliseconds each output was on in
+// onMs, if given, and returns the most outputs on at once.
+
+static uint8_t run(uint32_t ms, uint32_t *onMs = NULL) {
+  uint8_t most = 0;
+  for (uint32_t t = 0; t < ms; t++) {
+    HalClock::advance(1000000);
+    uint8_t on = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+      if (!HalGpio::read(pins[i])) continue;
+      on++;
+      if (onMs) onMs[i]++;
+    }
+    most = max(most, on);
+  }
+  return most;
+}
+
+// Sigma-delta with room for two of the three: the first gets the half it
+// asks for, the other two share the rest evenly rather than get all they ask
+// for, and onTime() says what each was granted, not what it asked for
+
+void testSigmaDeltaGrantedUnderBudget() {
+  SsrTimer::setMode(SSR_MODE_SIGMA_DELTA);
+  SsrTimer::setBudget(20);
+  for (uint8_t i = 1; i < 3; i++) SsrTimer::setOnTime(channels[i], CYCLE_MS);
+  SsrTimer::setOnTime(channels[0], CYCLE_MS / 2);
+  run(2 * CYCLE_MS);
+
+  uint32_t onMs[3] = { 0, 0, 0 };
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, run(CYCLE_MS, onMs));
+  TEST_ASSERT_UINT32_WITHIN(20, CYCLE_MS / 2, SsrTimer::onTime(channels[0]));
+  for (uint8_t i = 0; i < 3; i++) {
+    TEST_ASSERT_UINT32_WITHIN(CYCLE_MS / 100, onMs[i], SsrTimer::onTime(channels[i]));
+  }
+  TEST_ASSERT_UINT32_WITHIN(CYCLE_MS / 100, 3 * CYCLE_MS / 4, SsrTimer::onTime(channels[1]));
+}
+
+// Without a budget sigma-delta grants what is asked
+
+void testSigmaDeltaGrantedWithoutBudget() {
+  SsrTimer::setMode(SSR_MODE_SIGMA_DELTA);
+  SsrTimer::setOnTime(channels[0], 1234);
+  SsrTimer::setOnTime(channels[1], CYCLE_MS);
+  run(2 * CYCLE_MS);
+  TEST_ASSERT_UINT32_WITHIN(10, 1234, SsrTimer::onTime(channels[0]));
+  TEST_ASSERT_EQUAL_UINT32(CYCLE_MS, SsrTimer::onTime(channels[1]));
+}
+
+// A channel starved by a higher priority one builds up a backlog. Once cut
+// off it must not fire again, even when the budget frees up.
+
+void testCutOffDropsBacklog() {
+  SsrTimer::setMode(SSR_MODE_SIGMA_DELTA);
+  SsrTimer::setBudget(10);
+  SsrTimer::setOnTime(channels[0], CYCLE_MS);
+  SsrTimer::setOnTime(channels[1], CYCLE_MS);
+  run(CYCLE_MS);
+  TEST_ASSERT_EQUAL_UINT32(0, SsrTimer::onTime(channels[1]));
+
+  SsrTimer::cutOff(channels[1]);
+  SsrTimer::setOnTime(channels[0], 0);
+  uint32_t onMs[3] = { 0, 0, 0 };
+  run(2 * CYCLE_MS, onMs);
+  TEST_ASSERT_EQUAL_UINT32(0, onMs[1]);
+  TEST_ASSERT_EQUAL_UINT32(0, SsrTimer::onTime(channels[1]));
+}
+
+// Window mode under a budget with a 20 s cycle, longer than SSR_MAX_SLOTS
+// slots of SSR_SLOT_MS: the cycle keeps its length and the on time its
+// share of it
+
+void testLongCycleUnderBudget() {
+  SsrTimer::setBudget(30);
+  SsrTimer::begin(20000);
+  SsrTimer::setOnTime(channels[0], 15000);
+  run(20000);
+
+  uint32_t onMs[3] = { 0, 0, 0 };
+  uint32_t edges = HalGpio::edges(pins[0]);
+  run(40000, onMs);
+  TEST_ASSERT_EQUAL_UINT32(15000, SsrTimer::onTime(channels[0]));
+  TEST_ASSERT_UINT32_WITHIN(SSR_SLOT_MS, 30000, onMs[0]);
+  TEST_ASSERT_EQUAL_UINT32(4, HalGpio::edges(pins[0]) - edges);
+}
+
+// A cycle that isn't a whole number of slots keeps its length too
+
+void testOddCycleUnderBudget() {
+  SsrTimer::setBudget(30);
+  SsrTimer::begin(5025);
+  SsrTimer::setOnTime(channels[0], 5025);
+  SsrTimer::setOnTime(channels[1], 2500);
+  run(5025);
+
+  uint32_t onMs[3] = { 0, 0, 0 };
+  run(4 * 5025, onMs);
+  TEST_ASSERT_EQUAL_UINT32(5025, SsrTimer::onTime(channels[0]));
+  TEST_ASSERT_EQUAL_UINT32(4 * 5025, onMs[0]);
+  TEST_ASSERT_UINT32_WITHIN(4, 4 * 2500, onMs[1]);
+}
+
+// A priority out of range, e.g. -1 from the zones file, is capped rather
+// than making the slot planner in the interrupt go round forever. The
+// channel still comes after those of a real priority. Added last, as
+// channels can't be removed.
+
+void testPriorityOutOfRange() {
+  int8_t channel = SsrTimer::addChannel(15, -1, 10, 255);
+  TEST_ASSERT_TRUE(channel >= 0);
+  SsrTimer::setBudget(10);
+  SsrTimer::begin(CYCLE_MS);
+  SsrTimer::setOnTime(channels[0], CYCLE_MS);
+  SsrTimer::setOnTime(channel, CYCLE_MS);
+  run(2 * CYCLE_MS);
+  TEST_ASSERT_EQUAL_UINT32(CYCLE_MS, SsrTimer::onTime(channels[0]));
+  TEST_ASSERT_EQUAL_UINT32(0, SsrTimer::onTime(channel));
+
+  SsrTimer::setOnTime(channels[0], 0);
+  run(2 * CYCLE_MS);
+  TEST_ASSERT_EQUAL_UINT32(CYCLE_MS, SsrTimer::onTime(channel));
+}
+
+int main(int argc, char **argv) {
+  channels[0] = SsrTimer::addChannel(pins[0], -1, 10, 0);
+  channels[1] = SsrTimer::addChannel(pins[1], -1, 10, 1);
+  channels[2] = SsrTimer::addChannel(pins[2], -1, 10, 1);
+  UNITY_BEGIN();
+  RUN_TEST(testSigmaDeltaGrantedUnderBudget);
+  RUN_TEST(testSigmaDeltaGrantedWithoutBudget);
+  RUN_TEST(testCutOffDropsBacklog);
+  RUN_TEST(testLongCycleUnderBudget);
+  RUN_TEST(testOddCycleUnderBudget);
+  RUN_TEST(testPriorityOutOfRange);
+  return UNITY_END();
+}
@@ -0,0 +1,210 @@
+// What Telemetry puts in an update, and the cost of building one on the
+// host compared with parsing the same update from text. Run with:
+// pio test -e native -f test_telemetry
+
+#include <Arduino.h>
+#include <chrono>
+#include <new>
+#include <unity.h>
+#include "Hal.h"
+#include "Telemetry.h"
+
+#define BENCH_UPDATES 20000
+
+// Heap allocations, counted to see what building an update costs
+
+static uint32_t allocations;
+
+void *operator new(size_t size) {
+  allocations++;
+  void *p = malloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept {
+  free(p);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void wait(uint32_t ms) {
+  HalClock::advance((uint64_t) ms * 1000000);
+}
+
+// Add the signals of a zone, the way the telemetry task does
+
+static void addZone(Telemetry &telemetry, int8_t zone, float temp, const char *step) {
+  telemetry.add(zone, "sensors/temp", temp, 0.1, 2);
+  telemetry.add(zone, "output", 0.25, 0.02, 3);
+  telemetry.addText(zone, "profile/name", step);
+  telemetry.addDetail(zone, "pid/out", 1234.5678, 1);
+}
+
+// The first update has everything, keyed by path below the board's node,
+// with values rounded to their decimals and NAN as null
+
+void testFirstUpdate() {
+  Telemetry telemetry;
+  TEST_ASSERT_TRUE(telemetry.begin());
+  telemetry.add(-1, "sensors/pot", 512, 8, 0);
+  addZone(telemetry, 0, 65.314, "Mash");
+  telemetry.add(1, "sensors/temp", NAN, 0.1, 2);
+  TEST_ASSERT_TRUE(telemetry.end());
+  TEST_ASSERT_TRUE(telemetry.json().raw() ==
+                   "{\"sensors/pot\":512,\"zones/0/sensors/temp\":65.31,"
+                   "\"zones/0/output\":0.25,\"zones/0/profile/name\":\"Mash\","
+                   "\"zones/0/pid/out\":1234.6,\"zones/1/sensors/temp\":null,"
+                   "\"time\":{\".sv\":\"timestamp\"},"
+                   "\"telemetry/sent\":6,\"telemetry/suppressed\":0}");
+}
+
+// Later updates only have what moved by more than its deadband, with the
+// details along with it, and nothing at all if nothing moved
+
+void testChangesOnly() {
+  Telemetry telemetry;
+  telemetry.begin();
+  addZone(telemetry, 0, 65, "Mash");
+  telemetry.end();
+  telemetry.commit();
+
+  wait(TELEMETRY_MIN_INTERVAL);
+  TEST_ASSERT_TRUE(telemetry.begin());
+  addZone(telemetry, 0, 65.05, "Mash");
+  TEST_ASSERT_FALSE(telemetry.end());
+
+  wait(TELEMETRY_MIN_INTERVAL);
+  TEST_ASSERT_TRUE(telemetry.begin());
+  addZone(telemetry, 0, 65.2, "Mash");
+  TEST_ASSERT_TRUE(telemetry.end());
+  TEST_ASSERT_TRUE(telemetry.json().raw() ==
+                   "{\"zones/0/sensors/temp\":65.2,\"zones/0/pid/out\":1234.6,"
+                   "\"time\":{\".sv\":\"timestamp\"},"
+                   "\"telemetry/sent\":6,\"telemetry/suppressed\":6}");
+}
+
+// An update that wasn't sent isn't counted as published: what it had goes
+// out again next time, and so do the counts
+
+void testUncommitted() {
+  Telemetry telemetry;
+  telemetry.begin();
+  addZone(telemetry, 0, 65, "Mash");
+  telemetry.end();
+  telemetry.commit();
+
+  wait(TELEMETRY_MIN_INTERVAL);
+  telemetry.begin();
+  addZone(telemetry, 0, 66, "Mash");
+  TEST_ASSERT_TRUE(telemetry.end());
+  TEST_ASSERT_EQUAL_UINT32(1, telemetry.updates());
+  TEST_ASSERT_EQUAL_UINT32(4, telemetry.sent());
+
+  wait(TELEMETRY_MIN_INTERVAL);
+  TEST_ASSERT_TRUE(telemetry.begin());
+  addZone(telemetry, 0, 66.05, "Mash");
+  TEST_ASSERT_TRUE(telemetry.end());
+  TEST_ASSERT_TRUE(telemetry.json().raw() ==
+                   "{\"zones/0/sensors/temp\":66.05,\"zones/0/pid/out\":1234.6,"
+                   "\"time\":{\".sv\":\"timestamp\"},"
+                   "\"telemetry/sent\":6,\"telemetry/suppressed\":2}");
+  telemetry.commit();
+  TEST_ASSERT_EQUAL_UINT32(2, telemetry.updates());
+  TEST_ASSERT_EQUAL_UINT32(6, telemetry.sent());
+  TEST_ASSERT_EQUAL_UINT32(2, telemetry.suppressed());
+}
+
+// Profile step names come from the user, so quotes, backslashes and control
+// characters in them must not break the update
+
+void testTextEscaped() {
+  const char *name = "Mash \"in\" \\ 1\t\x01";
+  Telemetry telemetry;
+  telemetry.begin();
+  telemetry.addText(0, "profile/name", name);
+  TEST_ASSERT_TRUE(telemetry.end());
+  String text;
+  telemetry.json().toString(text);
+  FirebaseJson parsed;
+  TEST_ASSERT_TRUE(parsed.setJsonData(text));
+  FirebaseJsonData result;
+  TEST_ASSERT_TRUE(parsed.get(result, "time"));
+  TEST_ASSERT_TRUE(text.indexOf("\"Mash \\\"in\\\" \\\\ 1\\t\\u0001\"") >= 0);
+}
+
+// A changed name goes out even where a 16-bit hash of it wouldn't change,
+// and an unchanged one doesn't
+
+void testTextChanged() {
+  Telemetry telemetry;
+  telemetry.begin();
+  telemetry.addText(0, "profile/name", "Step Aa");
+  telemetry.end();
+  telemetry.commit();
+
+  wait(TELEMETRY_MIN_INTERVAL);
+  telemetry.begin();
+  telemetry.addText(0, "profile/name", "Step BB");
+  TEST_ASSERT_TRUE(telemetry.end());
+  TEST_ASSERT_TRUE(telemetry.json().raw() ==
+                   "{\"zones/0/profile/name\":\"Step BB\","
+                   "\"time\":{\".sv\":\"timestamp\"},"
+                   "\"telemetry/sent\":2,\"telemetry/suppressed\":0}");
+  telemetry.commit();
+
+  wait(TELEMETRY_MIN_INTERVAL);
+  telemetry.begin();
+  telemetry.addText(0, "profile/name", "Step BB");
+  TEST_ASSERT_FALSE(telemetry.end());
+}
+
+// Time to build a full three zone update, against also going through its
+// text and parsing that, as the task used to. Reported rather than checked.
+
+void benchmarkUpdate() {
+  Telemetry telemetry;
+  String text;
+  uint32_t allocated = allocations;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_UPDATES; i++) {
+    wait(TELEMETRY_MAX_INTERVAL);
+    telemetry.begin();
+    telemetry.add(-1, "sensors/pot", 512, 8, 0);
+    for (int8_t zone = 0; zone < 3; zone++) addZone(telemetry, zone, 65 + zone, "Mash");
+    telemetry.end();
+    telemetry.commit();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  allocated = allocations - allocated;
+  FirebaseJson parsed;
+  for (uint32_t i = 0; i < BENCH_UPDATES; i++) {
+    telemetry.json().toString(text);
+    parsed.setJsonData(text);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  char message[112];
+  snprintf(message, sizeof(message),
+           "built %.2f us with %.1f allocations, as text and parsed %.2f us more, %u bytes",
+           std::chrono::duration<double, std::micro>(t1 - t0).count() / BENCH_UPDATES,
+           (double) allocated / BENCH_UPDATES,
+           std::chrono::duration<double, std::micro>(t2 - t1).count() / BENCH_UPDATES,
+           (unsigned) text.length());
+  TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(testFirstUpdate);
+  RUN_TEST(testChangesOnly);
+  RUN_TEST(testUncommitted);
+  RUN_TEST(testTextEscaped);
+  RUN_TEST(testTextChanged);
+  RUN_TEST(benchmarkUpdate);
+  return UNITY_END();
+}
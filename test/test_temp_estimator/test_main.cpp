@@ -0,0 +1,120 @@
+// TempEstimator's probe checks in closed loop with the simulated kettle:
+// long holds and heating to an equilibrium must not look like a stuck probe,
+// while a reading that doesn't move under full power must. Run with:
+// pio test -e native -f test_temp_estimator
+
+#include <Arduino.h>
+#include <unity.h>
+#include "SimKettle.h"
+#include "TempEstimator.h"
+
+// 2 kW into 20 l of water, as the default zone and the bench
+
+#define HEAT_RATE 0.024
+#define CYCLE_MS 5000
+#define READING_MS 100
+#define HOLD_SETPOINT 65.0
+
+static const SimKettleParams kettleParams = { 20, 2000, 8, 5, 10, 20 };
+
+void setUp() {}
+void tearDown() {}
+
+// Run the kettle for seconds with readings every READING_MS. duty() gives
+// the duty for each SSR cycle from the estimator; it is switched as a window
+// at the start of the cycle. Returns the number of readings that failed a
+// probe check.
+
+template <typename DutyFn>
+static uint32_t run(SimKettle &kettle, TempEstimator &estimator, uint32_t seconds,
+                    DutyFn duty, bool regulating) {
+  uint32_t failed = 0;
+  float cycleDuty = 0;
+  for (uint64_t ms = 0; ms < (uint64_t) seconds * 1000; ms += READING_MS) {
+    if (ms % CYCLE_MS == 0) cycleDuty = duty(estimator);
+    kettle.setHeater(ms % CYCLE_MS < cycleDuty * CYCLE_MS, ms * 1000000);
+    kettle.advance((ms + READING_MS) * 1000000);
+    float reading = roundf(kettle.probeTemperature() * 100) / 100;
+    bool inBand = regulating && fabsf(reading - HOLD_SETPOINT) <= PROBE_STUCK_DELTA;
+    estimator.update(reading, cycleDuty, READING_MS / 1000.0, inBand);
+    if (estimator.check() != PROBE_OK) failed++;
+  }
+  return failed;
+}
+
+// Feedforward of the estimated losses plus a proportional correction, as
+// the zone's controller does at a hold
+
+static float holdDuty(const TempEstimator &estimator) {
+  float error = HOLD_SETPOINT - estimator.temperature();
+  return constrain(max(estimator.lossRate(), 0.0f) / HEAT_RATE + 0.25 * error, 0.0, 1.0);
+}
+
+// Heat from 20 C and hold 65 C for three hours. The heater makes up for the
+// losses while the reading hardly moves, which must not count as stuck,
+// even without the regulating hint from the zone.
+
+void testLongHold() {
+  SimKettle kettle;
+  kettle.begin(kettleParams, 20);
+  TempEstimator estimator(HEAT_RATE);
+  TEST_ASSERT_EQUAL_UINT32(0, run(kettle, estimator, 3 * 3600, holdDuty, false));
+  TEST_ASSERT_FLOAT_WITHIN(0.3, HOLD_SETPOINT, kettle.waterTemperature());
+}
+
+// The same hold, with the zone's hint that it is regulating
+
+void testLongHoldRegulating() {
+  SimKettle kettle;
+  kettle.begin(kettleParams, 20);
+  TempEstimator estimator(HEAT_RATE);
+  TEST_ASSERT_EQUAL_UINT32(0, run(kettle, estimator, 3 * 3600, holdDuty, true));
+}
+
+// A constant 16% duty, as under manual control, creeps towards a 60 C
+// equilibrium over hours
+
+void testManualEquilibrium() {
+  SimKettle kettle;
+  kettle.begin(kettleParams, 20);
+  TempEstimator estimator(HEAT_RATE);
+  uint32_t failed = run(kettle, estimator, 12 * 3600,
+                        [](const TempEstimator &) { return 0.16f; }, false);
+  TEST_ASSERT_EQUAL_UINT32(0, failed);
+  TEST_ASSERT_FLOAT_WITHIN(1, 59, kettle.waterTemperature());
+}
+
+// A reading stuck at 20 C under full power fails once the heater has put in
+// PROBE_STUCK_RISE, stays failed with the heater off, and clears once the
+// reading moves. The sudden move is a jump, so it takes two rounds of good
+// readings.
+
+void testStuckProbe() {
+  TempEstimator estimator(HEAT_RATE);
+  uint32_t readings = 0;
+  while (estimator.check() == PROBE_OK && readings < 10000) {
+    estimator.update(20, 1, READING_MS / 1000.0);
+    readings++;
+  }
+  TEST_ASSERT_EQUAL(PROBE_STUCK, estimator.check());
+  TEST_ASSERT_FLOAT_WITHIN(10, PROBE_STUCK_RISE / HEAT_RATE, readings * READING_MS / 1000.0);
+
+  for (uint16_t i = 0; i < 10 * PROBE_RECOVER_READINGS; i++) {
+    estimator.update(20, 0, READING_MS / 1000.0);
+  }
+  TEST_ASSERT_EQUAL(PROBE_STUCK, estimator.check());
+
+  for (uint16_t i = 0; i < 2 * PROBE_RECOVER_READINGS; i++) {
+    estimator.update(20 + PROBE_STUCK_DELTA + 0.1, 0, READING_MS / 1000.0);
+  }
+  TEST_ASSERT_EQUAL(PROBE_OK, estimator.check());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(testLongHold);
+  RUN_TEST(testLongHoldRegulating);
+  RUN_TEST(testManualEquilibrium);
+  RUN_TEST(testStuckProbe);
+  return UNITY_END();
+}